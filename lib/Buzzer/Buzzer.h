@@ -1,12 +1,67 @@
 /**
  * Buzzer.h - 增强版蜂鸣器控制库
  * 支持短响、长响、频率可变和响度可调的响声
+ * 支持异步模式：beep/longBeep立即返回，由service()在到时后停止发声
+ * 无音量控制引脚时，在ESP32上使用LEDC硬件PWM产生音调，占空比控制音量，不占用CPU
+ * 也不使用LEDC时，由硬件定时器中断在高/低电平时长到期时翻转引脚(软件PWM)，不忙等
+ * 扫频由定时器步进频率，音量渐变由LEDC硬件渐变完成，异步模式下不阻塞
+ * 提示音混音器：按事件类型限速、合并突发事件，高优先级提示音抢占低优先级
+ * 可直接播放Flash中的音符表和RTTTL铃声(见BuzzerTunes.h)，播放时逐个音符读入队列
+ * 可选的波表合成后端(见ToneSynth.h)：通过I2S以内置DAC输出带包络的正弦/方波/三角波
  */
 
 #ifndef BUZZER_H
 #define BUZZER_H
 
 #include <Arduino.h>
+#include "BuzzerTunes.h"
+#if defined(ARDUINO_ARCH_ESP32)
+#include "esp_timer.h"
+#endif
+
+#define BUZZER_LEDC_CHANNEL 2     // 默认LEDC通道(tone()默认使用通道0)
+#define BUZZER_LEDC_RESOLUTION 10 // LEDC占空比分辨率(位)
+#define BUZZER_MELODY_QUEUE_SIZE 32 // 旋律音符队列长度
+#define BUZZER_NOTE_GAP 50          // 音符之间的停顿(毫秒)
+#define BUZZER_TUNE_PREFETCH 4      // 播放Flash旋律时队列中预读的音符数
+#define BUZZER_SWEEP_MIN_STEP_US 500 // 扫频定时器最短步进间隔(微秒)
+#define BUZZER_FADE_STEP_MS 10       // 无硬件渐变时软件渐变的步进间隔(毫秒)
+#define BUZZER_SOFT_PWM_TIMER 1      // 软件PWM使用的硬件定时器编号
+#define BUZZER_SOFT_PWM_MIN_US 4     // 软件PWM最短电平时间(微秒)，限制中断频率
+
+/**
+ * 旋律播放结束回调
+ * @param completed true表示全部播放完毕，false表示被取消或被更高优先级的旋律抢占
+ */
+typedef void (*BuzzerMelodyCallback)(bool completed);
+
+class ToneSynth;
+
+/**
+ * 提示音事件类型
+ */
+enum BuzzerEvent {
+  BUZZER_EVENT_NAVIGATE = 0, // 移动选中项
+  BUZZER_EVENT_SELECT,       // 确认
+  BUZZER_EVENT_BACK,         // 返回
+  BUZZER_EVENT_ERROR,        // 错误/无效操作
+  BUZZER_EVENT_ALARM,        // 报警
+  BUZZER_EVENT_COUNT
+};
+
+/**
+ * 提示音事件的发声参数
+ * 同类事件两次发声至少间隔minInterval；上次发声后coalesceWindow内到达的同类事件直接并入上次发声，
+ * 之后到达的事件最多合并成一次延后发声，因此任意输入速率下每类事件的发声次数都有上限
+ */
+struct BuzzerFeedbackProfile {
+  uint16_t frequency;      // 频率(Hz)
+  uint16_t duration;       // 持续时间(毫秒)
+  int8_t volume;           // 音量(0-50)，-1表示使用当前音量
+  uint8_t priority;        // 优先级，数值越大越优先，低于正在发声的提示音时被丢弃
+  uint16_t minInterval;    // 同类事件最短发声间隔(毫秒)
+  uint16_t coalesceWindow; // 合并窗口(毫秒)
+};
 
 class Buzzer {
   public:
@@ -52,6 +107,7 @@ class Buzzer {
     
     /**
      * 发出频率变化的蜂鸣声
+     * 使用LEDC时由定时器回调步进频率，异步模式下立即返回
      * @param duration 总持续时间(毫秒)
      * @param startFreq 起始频率(Hz)
      * @param endFreq 结束频率(Hz)
@@ -61,7 +117,7 @@ class Buzzer {
     void sweepTone(unsigned int duration, unsigned int startFreq, unsigned int endFreq, unsigned int steps, int8_t volume = -1);
     
     /**
-     * 停止蜂鸣
+     * 停止蜂鸣(包括取消所有旋律)
      */
     void stop();
     
@@ -74,8 +130,78 @@ class Buzzer {
      */
     void playMelody(unsigned int melody[], unsigned int durations[], unsigned int length, int8_t volume = -1);
     
+    /**
+     * 将旋律加入音符队列，立即返回，由service()逐个推进音符
+     * 优先级高于正在播放的旋律时抢占(清除所有低优先级音符)，否则排在队尾
+     * 音符复制进队列，调用后数组可释放；队列(抢占之后)放不下时只复制前面放得下的部分，回调跟在最后一个复制的音符上
+     * 超过队列长度的长旋律用streamMelody
+     * @param melody 频率数组(0表示休止符)
+     * @param durations 对应的持续时间数组(毫秒)
+     * @param length 数组长度
+     * @param priority 优先级，数值越大越优先
+     * @param onComplete 播放结束回调，可为NULL
+     * @param volume 临时响度级别(0-50)，默认使用当前设置的响度
+     * @return 全部加入返回true；只加入了一部分时返回false；Flash旋律(或streamMelody的旋律)正在播放且本旋律优先级不高于它时
+     *         返回false，此时不加入任何音符，也不影响正在播放的旋律
+     */
+    bool queueMelody(const unsigned int melody[], const unsigned int durations[], unsigned int length,
+                     uint8_t priority = 0, BuzzerMelodyCallback onComplete = NULL, int8_t volume = -1);
+    
+    /**
+     * 播放存放在Flash中的音符表(buzzerNote编译生成)，service()按需逐个读入音符队列，不占用额外RAM
+     * 同一时间只能播放一个Flash旋律；优先级高于正在播放的旋律时抢占，否则排在队尾
+     * 阻塞模式下等待播放结束
+     * @param tune 音符表(PROGMEM)
+     * @param length 音符数
+     * @param priority 优先级，数值越大越优先
+     * @param onComplete 播放结束回调，可为NULL
+     * @param volume 临时响度级别(0-50)，默认使用当前设置的响度
+     * @return 开始播放返回true；已有不低于本优先级的Flash旋律在播放时返回false
+     */
+    bool playTune(const BuzzerNote* tune, uint16_t length, uint8_t priority = 0,
+                  BuzzerMelodyCallback onComplete = NULL, int8_t volume = -1);
+    
+    /**
+     * 边播放边从RAM中的数组读入音符，不复制整个旋律，长度不受队列限制
+     * 数组不复制，必须保持有效到播放结束(回调被调用或isMelodyPlaying()返回false)，不能用栈上的局部数组
+     * 排队和抢占规则同playTune，阻塞模式下等待播放结束
+     * @param melody 频率数组(0表示休止符)
+     * @param durations 对应的持续时间数组(毫秒)
+     * @param length 数组长度
+     * @param priority 优先级，数值越大越优先
+     * @param onComplete 播放结束回调，可为NULL
+     * @param volume 临时响度级别(0-50)，默认使用当前设置的响度
+     * @return 开始播放返回true；已有不低于本优先级的Flash旋律在播放时返回false
+     */
+    bool streamMelody(const unsigned int melody[], const unsigned int durations[], uint16_t length,
+                      uint8_t priority = 0, BuzzerMelodyCallback onComplete = NULL, int8_t volume = -1);
+    
+    /**
+     * 流式播放存放在Flash中的RTTTL铃声，每次只解析一个音符，字符串不复制到RAM
+     * 排队和抢占规则同playTune
+     * @param rtttl RTTTL字符串(PROGMEM)，如"name:d=4,o=5,b=120:c,e,g"
+     * @param priority 优先级，数值越大越优先
+     * @param onComplete 播放结束回调，可为NULL
+     * @param volume 临时响度级别(0-50)，默认使用当前设置的响度
+     * @return 开始播放返回true；格式错误或已有不低于本优先级的Flash旋律在播放时返回false
+     */
+    bool playRtttl(const char* rtttl, uint8_t priority = 0,
+                   BuzzerMelodyCallback onComplete = NULL, int8_t volume = -1);
+    
+    /**
+     * 取消所有排队和正在播放的旋律，回调以completed=false通知
+     */
+    void cancelMelody();
+    
+    /**
+     * 是否有旋律正在播放或排队(包括尚未读入队列的Flash旋律)
+     * @return 有返回true
+     */
+    bool isMelodyPlaying();
+    
     /**
      * 渐变音量
+     * 使用LEDC时由硬件渐变占空比(逐级细分，无阶跃噪声)，异步模式下立即返回
      * @param duration 渐变持续时间(毫秒)
      * @param startVolume 起始音量(0-50)
      * @param endVolume 结束音量(0-50)
@@ -83,11 +209,296 @@ class Buzzer {
      */
     void fadeVolume(unsigned int duration, uint8_t startVolume, uint8_t endVolume, unsigned int frequency = 1000);
     
+    /**
+     * 请求一个提示音事件(经过限速、合并和优先级仲裁，不保证立即发声)
+     * @param event 事件类型
+     */
+    void feedback(BuzzerEvent event);
+    
+    /**
+     * 设置某类事件的发声参数
+     * @param event 事件类型
+     * @param profile 发声参数
+     */
+    void setFeedbackProfile(BuzzerEvent event, const BuzzerFeedbackProfile &profile);
+    
+    /**
+     * 获取某类事件的发声参数
+     * @param event 事件类型
+     * @return 发声参数
+     */
+    BuzzerFeedbackProfile getFeedbackProfile(BuzzerEvent event);
+    
+    /**
+     * 设置异步模式
+     * 异步模式下beep/longBeep启动发声后立即返回，playMelody改为加入音符队列，需周期调用service()
+     * @param enable true为异步模式，false为阻塞模式(默认)
+     */
+    void setAsync(bool enable);
+    
+    /**
+     * 服务函数：到时后停止发声，播放延后的提示音，并推进旋律音符队列
+     * 应在主循环中频繁调用(MenuSystem::update会自动调用)
+     */
+    void service();
+    
+    /**
+     * 是否正在发声(短响、旋律或等待中的提示音)
+     * @return 正在发声返回true
+     */
+    bool isBusy();
+    
+    /**
+     * 设置LEDC通道(无音量控制引脚时使用)，需在begin()之前调用
+     * ESP32上默认使用BUZZER_LEDC_CHANNEL；其他平台默认不使用，启用后只记录频率和占空比
+     * @param channel LEDC通道(0-15)，设为-1表示不使用LEDC(退回定时器中断驱动的软件PWM)
+     */
+    void setLedcChannel(int8_t channel);
+    
+    /**
+     * 使用波表合成器作为发声后端(取代tone()/LEDC/音量引脚)，需在begin()之前调用
+     * ESP32上合成器由自己的任务填充DMA；主机上采样由service()补写到WAV文件(阻塞模式下在等待期间补写)
+     * @param synth 合成器，设为NULL恢复默认后端
+     */
+    void setSynth(ToneSynth* synth);
+    
+    /**
+     * 获取最近一次设置到LEDC的频率(非ESP32平台上仅记录，不驱动硬件)
+     * @return 频率(Hz)，未发声时为0
+     */
+    unsigned int getLedcFrequency();
+    
+    /**
+     * 获取最近一次设置到LEDC的占空比(非ESP32平台上仅记录，不驱动硬件)
+     * @return 占空比(0 - 2^BUZZER_LEDC_RESOLUTION-1)
+     */
+    uint32_t getLedcDuty();
+    
   private:
     uint8_t _pin;           // 蜂鸣器引脚
     int8_t _volumePin;      // 音量控制引脚(PWM)
     uint8_t _volumeLevel;   // 当前音量级别(0-50)
     bool _isActive;         // 蜂鸣器是否激活
+    bool _async;            // 是否为异步模式
+    unsigned long _toneStart;    // 当前发声开始时间(毫秒)
+    unsigned long _toneDuration; // 当前发声持续时间(毫秒)
+    int8_t _ledcChannel;    // LEDC通道，-1表示不使用
+    bool _ledcReady;        // LEDC是否已配置
+    unsigned int _ledcFrequency; // 记录的LEDC频率(Hz)
+    uint32_t _ledcDuty;     // 记录的LEDC占空比
+    ToneSynth* _synth;      // 波表合成后端，NULL表示不使用
+    
+    // 软件PWM(既没有音量引脚也不使用LEDC时)
+    volatile uint32_t _softPwmHighUs; // 高电平时长(微秒)
+    volatile uint32_t _softPwmLowUs;  // 低电平时长(微秒)
+    volatile bool _softPwmLevel;      // 当前引脚电平
+    bool _softPwmRunning;             // 是否正在输出
+    unsigned int _softPwmFrequency;   // 当前频率(Hz)
+    uint8_t _softPwmVolume;           // 当前音量(0-50)
+#if defined(ARDUINO_ARCH_ESP32)
+    hw_timer_t* _softPwmTimer;        // 翻转引脚的硬件定时器
+    static Buzzer* volatile _softPwmOwner; // 定时器中断服务的对象(同一时间只有一个)
+#else
+    unsigned long _softPwmNextEdge;   // 下一个边沿的时间(微秒)
+#endif
+    
+    // 旋律音符队列(环形缓冲区)
+    struct QueuedNote {
+      uint16_t frequency;   // 频率(Hz)，0为休止符
+      uint16_t duration;    // 持续时间(毫秒)
+      uint8_t priority;     // 所属旋律的优先级
+      uint8_t volume;       // 所属旋律的音量
+      BuzzerMelodyCallback onComplete; // 仅旋律最后一个音符携带回调
+    };
+    QueuedNote _melodyQueue[BUZZER_MELODY_QUEUE_SIZE];
+    uint8_t _melodyHead;    // 队首(当前音符)索引
+    uint8_t _melodyCount;   // 队列中的音符数
+    uint8_t _notePhase;     // 0:空闲 1:音符发声 2:音符间停顿
+    unsigned long _notePhaseStart; // 当前阶段开始时间(毫秒)
+    
+    // 正在读入队列的Flash旋律
+    uint8_t _tuneSource;    // 0:无 1:音符表 2:RTTTL 3:RAM中的频率/时值数组(streamMelody)
+    const BuzzerNote* _tuneNotes; // 音符表
+    const unsigned int* _tuneMelody;    // streamMelody的频率数组
+    const unsigned int* _tuneDurations; // streamMelody的时值数组
+    uint16_t _tuneLength;   // 音符表长度
+    uint16_t _tuneIndex;    // 下一个要读入的音符
+    BuzzerRtttlReader _rtttl; // RTTTL读取器
+    uint8_t _tunePriority;  // 旋律优先级
+    uint8_t _tuneVolume;    // 旋律音量
+    BuzzerMelodyCallback _tuneCallback; // 播放结束回调
+    
+    // 扫频/渐变效果(与短响一样占用输出，_isActive为true)
+    uint8_t _effect;        // 0:无 1:扫频 2:音量渐变
+    bool _effectHardware;   // 效果是否由定时器/LEDC硬件渐变驱动(否则由service()步进)
+    unsigned long _effectStartUs;  // 效果开始时间(微秒)
+    unsigned long _effectDurationUs; // 效果持续时间(微秒)
+    unsigned int _effectFrom;   // 起始频率(扫频)或起始音量(渐变)
+    unsigned int _effectTo;     // 结束频率(扫频)或结束音量(渐变)
+    unsigned int _effectSteps;  // 扫频步数
+    volatile unsigned int _effectStep; // 当前扫频步(渐变时为当前音量)
+    unsigned int _effectFrequency; // 渐变时的频率
+    uint8_t _effectVolume;      // 扫频时的音量
+    
+    // 提示音混音器
+    BuzzerFeedbackProfile _feedbackProfiles[BUZZER_EVENT_COUNT];
+    unsigned long _feedbackLast[BUZZER_EVENT_COUNT]; // 各类事件上次发声时间(毫秒)
+    uint8_t _feedbackPending;  // 等待延后发声的事件位图
+    uint8_t _feedbackPlayed;   // 至少发过一次声的事件位图
+    int8_t _feedbackSounding;  // 正在发声的提示音事件，-1表示无
+#if defined(ARDUINO_ARCH_ESP32)
+    esp_timer_handle_t _sweepTimer; // 扫频步进定时器
+    bool _ledcFadeReady;    // LEDC渐变服务是否已安装
+#endif
+    
+    /**
+     * 结束当前短响，若有旋律音符正在播放则恢复该音符
+     */
+    void _endBeep();
+    
+    /**
+     * 开始扫频或音量渐变，阻塞模式下等待效果结束
+     * @param effect 1:扫频 2:音量渐变
+     * @param duration 持续时间(毫秒)
+     */
+    void _startEffect(uint8_t effect, unsigned int duration);
+    
+    /**
+     * 由service()按时间推进软件步进的效果
+     */
+    void _serviceEffect();
+    
+    /**
+     * 停止扫频定时器/硬件渐变(不改变输出)
+     */
+    void _stopEffect();
+    
+    /**
+     * 按经过的时间计算扫频步并在步变化时更新频率
+     * @param elapsedUs 效果开始后经过的时间(微秒)
+     */
+    void _sweepTo(unsigned long elapsedUs);
+    
+    /**
+     * 尝试以LEDC硬件渐变启动音量渐变
+     * @return 成功返回true，否则退回软件步进
+     */
+    bool _startHardwareFade();
+    
+#if defined(ARDUINO_ARCH_ESP32)
+    /**
+     * 扫频定时器回调(在esp_timer任务中运行)
+     * @param arg Buzzer对象指针
+     */
+    static void _sweepTimerCallback(void* arg);
+#endif
+    
+    /**
+     * 按优先级仲裁并播放一个提示音事件
+     * @param event 事件类型
+     * @param now 当前时间(毫秒)
+     * @return 已发声返回true，被更高优先级的提示音挡住返回false
+     */
+    bool _playFeedback(uint8_t event, unsigned long now);
+    
+    /**
+     * 播放到期的延后提示音
+     */
+    void _serviceFeedback();
+    
+    /**
+     * 抢占：清除队列中所有优先级低于priority的音符，并以completed=false通知它们的回调
+     * @param priority 新旋律的优先级
+     */
+    void _preemptBelow(uint8_t priority);
+    
+    /**
+     * 开始读入Flash旋律(_tuneSource等已设置)，处理抢占，阻塞模式下等待结束
+     * @return 开始播放返回true
+     */
+    bool _startTune();
+    
+    /**
+     * 从Flash旋律读取音符补充队列，队列中最多保留BUZZER_TUNE_PREFETCH个音符
+     */
+    void _refillTune();
+    
+    /**
+     * 停止读入Flash旋律，尚未读完时以completed=false调用回调
+     */
+    void _cancelTune();
+    
+    /**
+     * 推进旋律音符队列
+     */
+    void _serviceMelody();
+    
+    /**
+     * 开始播放队首音符
+     */
+    void _startQueuedNote();
+    
+    /**
+     * 移除队首音符，若为旋律最后一个音符则调用回调
+     * @param completed 传给回调的完成标志
+     */
+    void _popQueuedNote(bool completed);
+    
+    /**
+     * 是否使用LEDC后端(没有合成器和音量引脚且启用了LEDC通道)
+     * @return 使用返回true
+     */
+    bool _usesLedc();
+    
+    /**
+     * 开始持续发声(不阻塞)
+     * @param frequency 频率(Hz)
+     * @param volume 音量级别(0-50)
+     */
+    void _startTone(unsigned int frequency, uint8_t volume);
+    
+    /**
+     * 只改变正在发声的频率(保持音量)
+     * @param frequency 频率(Hz)
+     */
+    void _setToneFrequency(unsigned int frequency);
+    
+    /**
+     * 只改变正在发声的音量(保持频率)
+     * @param volume 音量级别(0-50)
+     */
+    void _setToneVolume(uint8_t volume);
+    
+    /**
+     * 将音量级别换算为LEDC占空比
+     * @param volume 音量级别(0-50)
+     * @return 占空比
+     */
+    uint32_t _ledcDutyFor(uint8_t volume);
+    
+    /**
+     * 停止由_startTone开始的发声
+     */
+    void _stopTone();
+    
+    /**
+     * 配置LEDC通道并连接蜂鸣器引脚
+     */
+    void _setupLedc();
+    
+    /**
+     * 开始一次定时发声，异步模式下立即返回，阻塞模式下等待发声结束
+     * @param duration 持续时间(毫秒)
+     * @param frequency 频率(Hz)
+     * @param volume 音量级别(0-50)
+     */
+    void _timedTone(unsigned int duration, unsigned int frequency, uint8_t volume);
+    
+    /**
+     * 阻塞模式下的等待，使用合成器时等待期间继续补充采样
+     * @param ms 等待时间(毫秒)
+     */
+    void _wait(unsigned long ms);
     
     /**
      * 应用音量设置
@@ -96,13 +507,28 @@ class Buzzer {
     void _applyVolume(uint8_t volume);
     
     /**
-     * 使用软件PWM产生可控音量的音调
-     * @param pin 蜂鸣器引脚
+     * 设置软件PWM的频率和音量，未运行时启动定时器
      * @param frequency 频率(Hz)
-     * @param duration 持续时间(毫秒)
-     * @param volume 音量级别(0-50)
+     * @param volume 音量级别(0-50)，0为停止
+     */
+    void _softPwmSet(unsigned int frequency, uint8_t volume);
+    
+    /**
+     * 停止软件PWM并把引脚拉低
+     */
+    void _softPwmStop();
+    
+#if defined(ARDUINO_ARCH_ESP32)
+    /**
+     * 软件PWM定时器中断：翻转引脚并设置下一段电平的时长
+     */
+    static void IRAM_ATTR _softPwmIsr();
+#else
+    /**
+     * 没有定时器中断的平台上由service()翻转到期的边沿
      */
-    void _toneWithVolume(uint8_t pin, unsigned int frequency, unsigned long duration, uint8_t volume);
+    void _softPwmPoll();
+#endif
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,148 @@
+/**
+ * BuzzerTunes.h - 存放在Flash中的旋律
+ * 编译期音符描述：buzzerNote("C#5", 8, 120)在编译时换算成频率和时长，每个音符4字节
+ * 流式RTTTL解析：逐音符从Flash读取铃声字符串，不复制到RAM
+ *
+ * 用法：
+ *   static constexpr BuzzerNote startupTune[] PROGMEM = {
+ *     buzzerNote("C5", 8, 140), buzzerNote("E5", 8, 140), buzzerNote("G5", 4, 140), buzzerNote("R", 8, 140)
+ *   };
+ *   buzzer.playTune(startupTune, 4);
+ *
+ *   static const char alarmRtttl[] PROGMEM = "alarm:d=8,o=6,b=180:c,e,g,p,c,e,g";
+ *   buzzer.playRtttl(alarmRtttl);
+ */
+
+#ifndef BUZZER_TUNES_H
+#define BUZZER_TUNES_H
+
+#include <Arduino.h>
+
+/**
+ * 一个音符：频率(Hz，0为休止符)和持续时间(毫秒)，共4字节
+ */
+struct BuzzerNote {
+  uint16_t frequency;
+  uint16_t duration;
+};
+
+// 第8八度各音名的频率(Hz)，低八度依次减半
+constexpr uint16_t buzzerOctave8[12] = { 4186, 4435, 4699, 4978, 5274, 5588, 5920, 6272, 6645, 7040, 7459, 7902 };
+
+/**
+ * 无效音名时调用：不是constexpr函数，因此在constexpr数组中写错音名会在编译时报错；运行期(RTTTL)返回0，按休止符处理
+ */
+uint16_t buzzerInvalidNote();
+
+/**
+ * 音名字母对应的半音序号(C=0 ... B=11)，RTTTL中的h等同于b
+ * @return 非音名时返回-1
+ */
+constexpr int buzzerSemitone(char c) {
+  return (c == 'C' || c == 'c') ? 0 :
+         (c == 'D' || c == 'd') ? 2 :
+         (c == 'E' || c == 'e') ? 4 :
+         (c == 'F' || c == 'f') ? 5 :
+         (c == 'G' || c == 'g') ? 7 :
+         (c == 'A' || c == 'a') ? 9 :
+         (c == 'B' || c == 'b' || c == 'H' || c == 'h') ? 11 : -1;
+}
+
+/**
+ * 半音序号(可超出0-11，用于升降号跨八度)和八度换算为频率
+ * @param semitone 半音序号
+ * @param octave 八度(0-8)
+ * @return 频率(Hz)
+ */
+constexpr uint16_t buzzerFrequency(int semitone, int octave) {
+  return semitone < 0 ? buzzerFrequency(semitone + 12, octave - 1) :
+         semitone > 11 ? buzzerFrequency(semitone - 12, octave + 1) :
+         (octave < 0 || octave > 8) ? buzzerInvalidNote() :
+         (uint16_t)((buzzerOctave8[semitone] + ((1U << (8 - octave)) >> 1)) >> (8 - octave)); // 四舍五入
+}
+
+/**
+ * 按拍速换算音符时值
+ * @param division 音符类型(1全音符，4四分音符，8八分音符...)
+ * @param bpm 每分钟四分音符数
+ * @param dotted 是否附点(时值乘1.5)
+ * @return 持续时间(毫秒)
+ */
+constexpr uint16_t buzzerDuration(uint8_t division, uint16_t bpm, bool dotted) {
+  return (uint16_t)(240000UL / bpm / division * (dotted ? 3 : 2) / 2);
+}
+
+// 以下为buzzerNote的解析步骤：音名[#|b]八度[.]，休止符为R或P[.]
+constexpr bool buzzerIsRest(const char* name) {
+  return name[0] == 'R' || name[0] == 'r' || name[0] == 'P' || name[0] == 'p';
+}
+
+constexpr int buzzerAccidental(const char* name) {
+  return name[1] == '#' ? 1 : name[1] == 'b' ? -1 : 0;
+}
+
+constexpr int buzzerOctavePos(const char* name) {
+  return buzzerAccidental(name) != 0 ? 2 : 1;
+}
+
+constexpr bool buzzerIsDotted(const char* name) {
+  return buzzerIsRest(name) ? name[1] == '.' : name[buzzerOctavePos(name) + 1] == '.';
+}
+
+constexpr uint16_t buzzerNoteFrequency(const char* name) {
+  return buzzerIsRest(name) ? 0 :
+         (buzzerSemitone(name[0]) < 0 || name[buzzerOctavePos(name)] < '0' || name[buzzerOctavePos(name)] > '8') ? buzzerInvalidNote() :
+         buzzerFrequency(buzzerSemitone(name[0]) + buzzerAccidental(name), name[buzzerOctavePos(name)] - '0');
+}
+
+/**
+ * 编译期音符：在constexpr数组初始化中使用时，音名在编译时换算，数组可整体放在Flash中
+ * @param name 音名，如"A4"、"C#5"、"Bb3"、"E5."(附点)、"R"(休止符)
+ * @param division 音符类型(1全音符，4四分音符，8八分音符...)
+ * @param bpm 每分钟四分音符数
+ * @return 音符
+ */
+constexpr BuzzerNote buzzerNote(const char* name, uint8_t division, uint16_t bpm) {
+  return BuzzerNote{ buzzerNoteFrequency(name), buzzerDuration(division, bpm, buzzerIsDotted(name)) };
+}
+
+/**
+ * 流式RTTTL读取器
+ * 只保存当前读取位置和默认参数，每次调用next()从Flash解析一个音符
+ */
+class BuzzerRtttlReader {
+  public:
+    BuzzerRtttlReader();
+
+    /**
+     * 解析RTTTL头部("名称:d=4,o=5,b=63:")并定位到第一个音符
+     * @param rtttl 存放在Flash(PROGMEM)中的RTTTL字符串
+     * @return 头部有效且至少有一个音符时返回true
+     */
+    bool begin(const char* rtttl);
+
+    /**
+     * 读取下一个音符
+     * @param note 输出的音符
+     * @return 成功返回true；没有更多音符或格式错误时返回false
+     */
+    bool next(BuzzerNote &note);
+
+    /**
+     * 是否已没有更多音符
+     * @return 没有返回true
+     */
+    bool done();
+
+  private:
+    const char* _pos;     // 当前读取位置(Flash地址)
+    uint8_t _duration;    // 默认音符类型
+    uint8_t _octave;      // 默认八度
+    uint16_t _bpm;        // 拍速
+
+    char _peek();
+    uint16_t _readNumber();
+    void _skipSeparators();
+};
+
+#endif
@@ -0,0 +1,283 @@
+/**
+ * ToneSynth.cpp - 波表音调合成器实现
+ */
+
+#include "ToneSynth.h"
+#include <math.h>
+#if defined(ARDUINO_ARCH_ESP32)
+#include "driver/i2s.h"
+#include "driver/dac.h"
+#endif
+
+#if defined(ARDUINO_ARCH_ESP32)
+#define SYNTH_LOCK() portENTER_CRITICAL(&_lock)
+#define SYNTH_UNLOCK() portEXIT_CRITICAL(&_lock)
+#else
+#define SYNTH_LOCK()
+#define SYNTH_UNLOCK()
+#endif
+
+int8_t ToneSynth::_sineTable[1 << TONE_SYNTH_TABLE_BITS];
+bool ToneSynth::_sineReady = false;
+
+ToneSynth::ToneSynth(uint32_t sampleRate) {
+  _sampleRate = sampleRate;
+  _waveform = TONE_WAVE_SINE;
+  _phase = 0;
+  _phaseStep = 0;
+  _gain = 0;
+  _targetGain = 0;
+  _gainStep = 0;
+  _attackMs = 5;   // 5ms起音/释音足以消除咔嗒声
+  _releaseMs = 5;
+  _running = false;
+#if defined(ARDUINO_ARCH_ESP32)
+  _task = NULL;
+  portMUX_INITIALIZE(&_lock);
+#endif
+#ifndef ARDUINO
+  _wav = NULL;
+  _wavSamples = 0;
+  _wavLastMs = 0;
+#endif
+}
+
+bool ToneSynth::begin() {
+  if (!_sineReady) {
+    const int size = 1 << TONE_SYNTH_TABLE_BITS;
+    for (int i = 0; i < size; i++) {
+      _sineTable[i] = (int8_t)lroundf(127.0f * sinf(2.0f * (float)M_PI * i / size));
+    }
+    _sineReady = true;
+  }
+#if defined(ARDUINO_ARCH_ESP32)
+  if (_running) return true;
+  i2s_config_t config = {};
+  config.mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_TX | I2S_MODE_DAC_BUILT_IN);
+  config.sample_rate = _sampleRate;
+  config.bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT; // 内置DAC取每个采样的高8位
+  config.channel_format = I2S_CHANNEL_FMT_RIGHT_LEFT;
+  config.communication_format = I2S_COMM_FORMAT_STAND_MSB;
+  config.intr_alloc_flags = 0;
+  config.dma_buf_count = TONE_SYNTH_DMA_BUFFERS;
+  config.dma_buf_len = TONE_SYNTH_BLOCK;
+  config.use_apll = false;
+  config.tx_desc_auto_clear = false; // 任务休眠时DMA重复最后写入的零点缓冲区
+  if (i2s_driver_install(I2S_NUM_0, &config, 0, NULL) != ESP_OK) return false;
+  i2s_set_pin(I2S_NUM_0, NULL);
+  i2s_set_dac_mode(I2S_DAC_CHANNEL_RIGHT_EN); // 右声道 = DAC1 = GPIO25
+  _running = true;
+  if (xTaskCreatePinnedToCore(_feedTask, "ToneSynth", TONE_SYNTH_TASK_STACK, this,
+                              TONE_SYNTH_TASK_PRIORITY, (TaskHandle_t*)&_task, TONE_SYNTH_TASK_CORE) != pdPASS) {
+    _running = false;
+    i2s_driver_uninstall(I2S_NUM_0);
+    return false;
+  }
+  return true;
+#else
+  _running = true;
+  return true;
+#endif
+}
+
+void ToneSynth::end() {
+  if (!_running) return;
+#if defined(ARDUINO_ARCH_ESP32)
+  _running = false;
+  // 让任务写完当前块后自行退出，不在它持有I2S驱动时删除它
+  while (_task != NULL) {
+    _wakeTask();
+    delay(1);
+  }
+  i2s_driver_uninstall(I2S_NUM_0);
+  dac_output_disable(DAC_CHANNEL_1);
+#elif !defined(ARDUINO)
+  closeWav();
+#endif
+  _running = false;
+}
+
+void ToneSynth::setWaveform(ToneWaveform waveform) {
+  SYNTH_LOCK();
+  _waveform = waveform;
+  SYNTH_UNLOCK();
+}
+
+void ToneSynth::setEnvelope(uint16_t attackMs, uint16_t releaseMs) {
+  _attackMs = attackMs;
+  _releaseMs = releaseMs;
+}
+
+void ToneSynth::_rampTo(int32_t target, uint16_t ms) {
+  uint32_t samples = (uint32_t)ms * _sampleRate / 1000;
+  int32_t gain = _gain;
+  int32_t distance = target > gain ? target - gain : gain - target;
+  int32_t step = samples > 0 ? distance / (int32_t)samples : distance;
+  if (step == 0) step = 1;
+  SYNTH_LOCK();
+  _targetGain = target;
+  _gainStep = step;
+  SYNTH_UNLOCK();
+#if defined(ARDUINO_ARCH_ESP32)
+  if (target > 0) _wakeTask();
+#endif
+}
+
+void ToneSynth::noteOn(unsigned int frequency, uint8_t volume) {
+  setFrequency(frequency);
+  setVolume(volume);
+}
+
+void ToneSynth::noteOff() {
+  _rampTo(0, _releaseMs);
+}
+
+void ToneSynth::setFrequency(unsigned int frequency) {
+  uint32_t step = (uint32_t)(((uint64_t)frequency << 32) / _sampleRate);
+  SYNTH_LOCK();
+  _phaseStep = step;
+  SYNTH_UNLOCK();
+}
+
+void ToneSynth::setVolume(uint8_t volume) {
+  if (volume > 50) volume = 50;
+  _rampTo((int32_t)volume * 65536 / 50, _attackMs);
+}
+
+bool ToneSynth::isSilent() {
+  return _gain == 0 && _targetGain == 0;
+}
+
+int8_t ToneSynth::_waveAt(ToneWaveform waveform, uint32_t phase) {
+  switch (waveform) {
+    case TONE_WAVE_SQUARE:
+      return (phase & 0x80000000UL) ? -127 : 127;
+    case TONE_WAVE_TRIANGLE: {
+      // 前半周期从-127升到127，后半周期降回
+      int32_t x = (int32_t)(phase >> 24); // 0..255
+      return (int8_t)(x < 128 ? 2 * x - 127 : 383 - 2 * x);
+    }
+    default:
+      return _sineTable[phase >> (32 - TONE_SYNTH_TABLE_BITS)];
+  }
+}
+
+void ToneSynth::render(uint8_t* out, size_t count) {
+  // 每块读取一次发声参数，渲染期间主循环的修改留到下一块生效
+  SYNTH_LOCK();
+  ToneWaveform waveform = _waveform;
+  uint32_t phaseStep = _phaseStep;
+  int32_t target = _targetGain;
+  int32_t step = _gainStep;
+  SYNTH_UNLOCK();
+  int32_t gain = _gain;
+  uint32_t phase = _phase;
+  for (size_t i = 0; i < count; i++) {
+    if (gain < target) {
+      gain += step;
+      if (gain > target) gain = target;
+    } else if (gain > target) {
+      gain -= step;
+      if (gain < target) gain = target;
+    }
+    if (gain == 0) {
+      out[i] = 128;
+    } else {
+      out[i] = (uint8_t)(128 + ((_waveAt(waveform, phase) * gain) >> 16));
+    }
+    phase += phaseStep;
+  }
+  _phase = phase;
+  _gain = gain;
+}
+
+#if defined(ARDUINO_ARCH_ESP32)
+void ToneSynth::_wakeTask() {
+  TaskHandle_t task = _task;
+  if (task != NULL) xTaskNotifyGive(task);
+}
+
+void ToneSynth::_feedTask(void* arg) {
+  ToneSynth* self = (ToneSynth*)arg;
+  uint8_t block[TONE_SYNTH_BLOCK];
+  uint8_t silentBlocks = 0;
+  while (self->_running) {
+    if (self->isSilent()) {
+      // DMA环中全部是零点后停止渲染，DMA重复输出静音；发声前的通知会保留，不会错过
+      if (silentBlocks > TONE_SYNTH_DMA_BUFFERS) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        silentBlocks = 0;
+        continue;
+      }
+      silentBlocks++;
+    } else {
+      silentBlocks = 0;
+    }
+    self->render(block, TONE_SYNTH_BLOCK);
+    for (size_t i = 0; i < TONE_SYNTH_BLOCK; i++) {
+      self->_frames[2 * i] = self->_frames[2 * i + 1] = (uint16_t)block[i] << 8; // 左右声道相同
+    }
+    // 阻塞到DMA有空闲缓冲区，渲染节奏由DMA决定
+    size_t written = 0;
+    i2s_write(I2S_NUM_0, self->_frames, sizeof(self->_frames), &written, portMAX_DELAY);
+  }
+  self->_task = NULL;
+  vTaskDelete(NULL);
+}
+#endif
+
+void ToneSynth::pump() {
+#if !defined(ARDUINO)
+  if (!_running || _wav == NULL) return;
+  uint8_t block[TONE_SYNTH_BLOCK];
+  unsigned long now = millis();
+  uint32_t due = (uint32_t)((uint64_t)(now - _wavLastMs) * _sampleRate / 1000);
+  _wavLastMs += (unsigned long)((uint64_t)due * 1000 / _sampleRate);
+  while (due > 0) {
+    size_t count = due < TONE_SYNTH_BLOCK ? due : TONE_SYNTH_BLOCK;
+    render(block, count);
+    fwrite(block, 1, count, _wav);
+    _wavSamples += count;
+    due -= count;
+  }
+#endif
+}
+
+#ifndef ARDUINO
+static void writeLE32(FILE* f, uint32_t v) {
+  uint8_t b[4] = { (uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24) };
+  fwrite(b, 1, 4, f);
+}
+
+static void writeLE16(FILE* f, uint16_t v) {
+  uint8_t b[2] = { (uint8_t)v, (uint8_t)(v >> 8) };
+  fwrite(b, 1, 2, f);
+}
+
+bool ToneSynth::openWav(const char* path) {
+  closeWav();
+  _wav = fopen(path, "wb");
+  if (_wav == NULL) return false;
+  // 44字节WAV头，长度在closeWav()中补全
+  fwrite("RIFF", 1, 4, _wav); writeLE32(_wav, 0); fwrite("WAVE", 1, 4, _wav);
+  fwrite("fmt ", 1, 4, _wav); writeLE32(_wav, 16);
+  writeLE16(_wav, 1); writeLE16(_wav, 1);                   // PCM，单声道
+  writeLE32(_wav, _sampleRate); writeLE32(_wav, _sampleRate); // 采样率，字节率
+  writeLE16(_wav, 1); writeLE16(_wav, 8);                   // 块对齐，8位
+  fwrite("data", 1, 4, _wav); writeLE32(_wav, 0);
+  _wavSamples = 0;
+  _wavLastMs = millis();
+  return true;
+}
+
+void ToneSynth::closeWav() {
+  if (_wav == NULL) return;
+  if (_wavSamples & 1) fputc(128, _wav); // RIFF块按偶数字节对齐
+  fseek(_wav, 4, SEEK_SET);
+  writeLE32(_wav, 36 + _wavSamples + (_wavSamples & 1));
+  fseek(_wav, 40, SEEK_SET);
+  writeLE32(_wav, _wavSamples);
+  fclose(_wav);
+  _wav = NULL;
+}
+#endif
@@ -0,0 +1,177 @@
+/**
+ * ToneSynth.h - 波表音调合成器
+ * 正弦/方波/三角波波表 + 相位累加器 + 起音/释音包络，输出8位无符号采样
+ * ESP32上通过I2S DMA以内置DAC模式输出到GPIO25(DAC1)，主机上把同样的采样写入WAV文件便于离线检查
+ * 通过Buzzer::setSynth()作为Buzzer的发声后端；ESP32上由独立的任务阻塞写入DMA，输出不受主循环帧时间影响，
+ * 静音时DMA重复输出已填好的零点缓冲区，任务休眠直到下一次发声
+ */
+
+#ifndef TONE_SYNTH_H
+#define TONE_SYNTH_H
+
+#include <Arduino.h>
+#ifndef ARDUINO
+#include <stdio.h>
+#endif
+
+#define TONE_SYNTH_SAMPLE_RATE 16000 // 默认采样率(Hz)
+#define TONE_SYNTH_BLOCK 128         // 每次渲染的采样数
+#define TONE_SYNTH_DMA_BUFFERS 4     // I2S DMA缓冲区个数
+#define TONE_SYNTH_TABLE_BITS 8      // 波表长度 2^8
+#define TONE_SYNTH_TASK_STACK 2048   // 填充DMA的任务栈大小
+#define TONE_SYNTH_TASK_PRIORITY 5   // 高于主循环和输入任务，渲染一块只需几十微秒
+#define TONE_SYNTH_TASK_CORE 0       // 与主循环(核心1)分开，刷屏不影响出声
+
+/**
+ * 波形
+ */
+enum ToneWaveform {
+  TONE_WAVE_SINE = 0,
+  TONE_WAVE_SQUARE,
+  TONE_WAVE_TRIANGLE
+};
+
+class ToneSynth {
+  public:
+    /**
+     * 构造函数
+     * @param sampleRate 采样率(Hz)
+     */
+    ToneSynth(uint32_t sampleRate = TONE_SYNTH_SAMPLE_RATE);
+
+    /**
+     * 启动输出：ESP32上安装I2S驱动、启用内置DAC1(GPIO25)并创建填充DMA的任务，其他平台只初始化状态
+     * @return 成功返回true
+     */
+    bool begin();
+
+    /**
+     * 停止输出，结束填充任务并释放I2S驱动(主机上关闭WAV文件)
+     */
+    void end();
+
+#ifndef ARDUINO
+    /**
+     * 主机后端：之后pump()按经过的时间把采样写入WAV文件(8位单声道)
+     * @param path 文件路径
+     * @return 打开成功返回true
+     */
+    bool openWav(const char* path);
+
+    /**
+     * 补全WAV文件头中的长度并关闭文件
+     */
+    void closeWav();
+#endif
+
+    /**
+     * 设置波形
+     * @param waveform 波形
+     */
+    void setWaveform(ToneWaveform waveform);
+
+    /**
+     * 设置包络
+     * @param attackMs 起音时间(毫秒)，从静音升到目标音量
+     * @param releaseMs 释音时间(毫秒)，从当前音量降到静音
+     */
+    void setEnvelope(uint16_t attackMs, uint16_t releaseMs);
+
+    /**
+     * 开始发声(正在发声时平滑过渡到新的频率和音量，不重置相位)
+     * @param frequency 频率(Hz)
+     * @param volume 音量级别(0-50)
+     */
+    void noteOn(unsigned int frequency, uint8_t volume);
+
+    /**
+     * 进入释音阶段
+     */
+    void noteOff();
+
+    /**
+     * 改变频率(相位连续)
+     * @param frequency 频率(Hz)
+     */
+    void setFrequency(unsigned int frequency);
+
+    /**
+     * 改变音量，按起音时间平滑过渡
+     * @param volume 音量级别(0-50)
+     */
+    void setVolume(uint8_t volume);
+
+    /**
+     * 是否已完全静音(释音结束)
+     * @return 静音返回true
+     */
+    bool isSilent();
+
+    /**
+     * 渲染采样
+     * @param out 输出缓冲区(8位无符号，128为零点)
+     * @param count 采样数
+     */
+    void render(uint8_t* out, size_t count);
+
+    /**
+     * 主机上按经过的时间把采样补写到WAV文件(Buzzer::service()会调用)
+     * ESP32上DMA由后台任务填充，这里不做任何事
+     */
+    void pump();
+
+  private:
+    uint32_t _sampleRate;
+    ToneWaveform _waveform;
+    uint32_t _phase;          // 相位累加器(一个周期为2^32)
+    uint32_t _phaseStep;      // 每个采样的相位增量
+    int32_t _gain;            // 当前增益(Q16，65536为满幅)
+    int32_t _targetGain;      // 目标增益
+    int32_t _gainStep;        // 每个采样的增益变化量(绝对值)
+    uint16_t _attackMs;
+    uint16_t _releaseMs;
+    bool _running;
+#if defined(ARDUINO_ARCH_ESP32)
+    uint16_t _frames[TONE_SYNTH_BLOCK * 2]; // 待写入I2S的立体声帧(高8位为DAC值)
+    TaskHandle_t volatile _task; // 填充DMA的任务，退出时置为NULL
+    portMUX_TYPE _lock;       // 保护发声参数(主循环写入，填充任务按块读取)
+#endif
+#ifndef ARDUINO
+    FILE* _wav;
+    uint32_t _wavSamples;     // 已写入的采样数
+    unsigned long _wavLastMs; // 上次补写的时间
+#endif
+
+    static int8_t _sineTable[1 << TONE_SYNTH_TABLE_BITS];
+    static bool _sineReady;
+
+    /**
+     * 设置目标增益并按给定时间计算斜率
+     * @param target 目标增益(Q16)
+     * @param ms 过渡时间(毫秒)
+     */
+    void _rampTo(int32_t target, uint16_t ms);
+
+    /**
+     * 当前相位处的波形值
+     * @param waveform 波形
+     * @param phase 相位
+     * @return -127..127
+     */
+    static int8_t _waveAt(ToneWaveform waveform, uint32_t phase);
+
+#if defined(ARDUINO_ARCH_ESP32)
+    /**
+     * 填充DMA的任务：渲染一块后阻塞写入I2S，DMA有空闲缓冲区时才继续，写满静音后休眠到下一次发声
+     * @param arg ToneSynth对象
+     */
+    static void _feedTask(void* arg);
+
+    /**
+     * 唤醒休眠的填充任务
+     */
+    void _wakeTask();
+#endif
+};
+
+#endif
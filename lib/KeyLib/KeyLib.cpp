@@ -1,122 +1,749 @@
 #include "KeyLib.h"
+#if defined(CONFIG_IDF_TARGET_ESP32) || defined(CONFIG_IDF_TARGET_ESP32S2) || defined(CONFIG_IDF_TARGET_ESP32S3)
+#include "soc/gpio_struct.h"
+#define KEYLIB_GPIO_REGISTERS  // GPIO.in为GPIO0-31，GPIO.in1为GPIO32及以上
+#endif
+
+// 手势状态
+enum {
+  GESTURE_IDLE = 0,   // 松开
+  GESTURE_DOWN,       // 第一次按下，等待长按或松开
+  GESTURE_UP_WAIT,    // 第一次松开，等待第二次按下或双击间隔结束
+  GESTURE_DOWN2,      // 第二次按下，等待松开(双击)或长按
+  GESTURE_LONG,       // 长按之后按住不放
+  GESTURE_STATES
+};
+
+// 手势输入
+enum {
+  GESTURE_PRESS = 0,
+  GESTURE_RELEASE,
+  GESTURE_TIMEOUT
+};
+
+// 锁存位
+#define LATCH_CLICK  0x01
+#define LATCH_DOUBLE 0x02
+#define LATCH_LONG   0x04
+
+#define GESTURE_NO_TIMEOUT 0xFFFFFFFFUL
+
+// 手势状态转移表：[状态][输入] -> {下一状态, 产生的手势事件}
+struct GestureTransition {
+  uint8_t next;
+  uint8_t event;
+};
+
+static const GestureTransition gestureTable[GESTURE_STATES][3] = {
+  //              按下                                  释放                                       超时
+  /* IDLE    */ { { GESTURE_DOWN,  KEY_EVENT_NONE },    { GESTURE_IDLE,    KEY_EVENT_NONE },         { GESTURE_IDLE, KEY_EVENT_NONE } },
+  /* DOWN    */ { { GESTURE_DOWN,  KEY_EVENT_NONE },    { GESTURE_UP_WAIT, KEY_EVENT_NONE },         { GESTURE_LONG, KEY_EVENT_LONG_PRESS } },
+  /* UP_WAIT */ { { GESTURE_DOWN2, KEY_EVENT_NONE },    { GESTURE_UP_WAIT, KEY_EVENT_NONE },         { GESTURE_IDLE, KEY_EVENT_CLICK } },
+  /* DOWN2   */ { { GESTURE_DOWN2, KEY_EVENT_NONE },    { GESTURE_IDLE,    KEY_EVENT_DOUBLE_CLICK }, { GESTURE_LONG, KEY_EVENT_LONG_PRESS } },
+  /* LONG    */ { { GESTURE_LONG,  KEY_EVENT_NONE },    { GESTURE_IDLE,    KEY_EVENT_NONE },         { GESTURE_LONG, KEY_EVENT_REPEAT } },
+};
 
 KeyLib::KeyLib(unsigned long debounceTime) {
   debounceDelay = debounceTime;
   keyCount = 0;
+  defaultLongPressTime = 1000;
+  defaultDoubleClickTime = 0;
+  defaultRepeatInterval = 0;
+  eventHead = 0;
+  eventCount = 0;
+  chordCount = 0;
+  chordWindow = 80;
+  chordMemberMask = 0;
+  pressedSlots = 0;
+  chordPendingSlots = 0;
+  chordSuppressedSlots = 0;
+  lastUpdateTime = 0;
+  updatedOnce = false;
+  interruptMode = false;
+  edgeHead = 0;
+  edgeTail = 0;
+  edgeOverflow = false;
+  scanMode = false;
+  scanKeyMask = 0;
+  scanActiveHighMask = 0;
+  scanState = 0;
+  scanCnt0 = ~0ULL;
+  scanCnt1 = ~0ULL;
+  scanPressed = 0;
+  scanReleased = 0;
+  lastScanTime = 0;
   
   // 初始化所有按键状态
   for (int i = 0; i < MAX_KEYS; i++) {
-    keyStates[i] = {false, false, 0, 0, 0, false, false, 0};
+    keyStates[i] = {0, LOW, 0, false, false, 0, GESTURE_IDLE, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+  }
+  for (int i = 0; i < KEYLIB_MAX_KEY_IDS; i++) {
+    pinSlot[i] = -1;
   }
+  virtualLevels = 0;
+  sourceCount = 0;
+  wakeCallback = NULL;
+  readHook = NULL;
+  millisHook = NULL;
+  microsHook = NULL;
 }
 
-int KeyLib::getKeyIndex(uint8_t pin) {
-  // 查找已存在的按键
-  for (int i = 0; i < keyCount; i++) {
-    if (i == pin) return i;
+bool KeyLib::registerKey(uint8_t pin) {
+  return getKeyIndex(pin) >= 0;
+}
+
+bool KeyLib::registerKey(uint8_t pin, const KeyConfig &config) {
+  if (pin >= KEYLIB_MAX_KEY_IDS) return false;
+  int index = pinSlot[pin];
+  bool added = index < 0;
+  if (added) {
+    if (keyCount >= MAX_KEYS) return false;
+    index = keyCount++;
+    pinSlot[pin] = index;
+    KeyState &state = keyStates[index];
+    state.pin = pin;
+    state.longPressTime = defaultLongPressTime;
+    state.doubleClickTime = defaultDoubleClickTime;
+    state.repeatInterval = defaultRepeatInterval;
+    state.repeatMinInterval = defaultRepeatInterval;
+    state.repeatRampTime = 0;
   }
   
-  // 如果不存在，创建新的按键状态
-  if (keyCount < MAX_KEYS) {
-    pinMode(pin, INPUT_PULLUP);  // 默认使用上拉输入模式
-    int index = keyCount;
-    keyCount++;
-    return index;
+  KeyState &state = keyStates[index];
+  bool levelChanged = !added && state.activeLevel != config.activeLevel;
+  state.activeLevel = config.activeLevel;
+  state.debounce = config.debounce > 0 ? config.debounce : debounceDelay;
+  uint64_t bit = 1ULL << pin;
+  scanKeyMask |= bit;
+  
+  if (pin >= KEYLIB_VIRTUAL_KEY_BASE) {
+    // 虚拟按键：没有引脚，也不挂接中断
+    if (added && scanMode && readKey(state)) {
+      scanState |= bit;
+      state.lastState = true;
+      state.currentState = true;
+    }
+    return true;
+  }
+  
+  if (config.pull == KEY_PULL_UP) {
+    pinMode(pin, INPUT_PULLUP);
+  } else if (config.pull == KEY_PULL_DOWN) {
+#ifdef INPUT_PULLDOWN
+    pinMode(pin, INPUT_PULLDOWN);
+#else
+    pinMode(pin, INPUT);  // 不支持内部下拉的平台需外接下拉电阻
+#endif
+  } else {
+    pinMode(pin, INPUT);
+  }
+  
+  if (config.activeLevel == HIGH) {
+    scanActiveHighMask |= bit;
+  } else {
+    scanActiveHighMask &= ~bit;
   }
   
-  // 如果超过最大按键数，返回第一个按键的索引
-  return 0;
+  if (!added) {
+    if (!levelChanged) return true;
+    // 有效电平改变：已记录的边沿按旧电平解释，先处理完，再以新电平重新开始
+#if defined(ARDUINO_ARCH_ESP32)
+    if (interruptMode) {
+      detachInterrupt(digitalPinToInterrupt(pin));
+      processEdges();
+      isrArgs[index].lib = this;
+      isrArgs[index].pin = pin;
+      isrArgs[index].activeLevel = config.activeLevel;
+    }
+#endif
+    reseedKey(state);
+#if defined(ARDUINO_ARCH_ESP32)
+    if (interruptMode) {
+      attachInterruptArg(digitalPinToInterrupt(pin), edgeIsr, &isrArgs[index], CHANGE);
+    }
+#endif
+    return true;
+  }
+  
+  if (scanMode && readKey(state)) {
+    // 以当前电平为初始消抖状态，避免注册时产生一次假按下
+    scanState |= bit;
+    state.lastState = true;
+    state.currentState = true;
+  }
+#if defined(ARDUINO_ARCH_ESP32)
+  if (interruptMode) {
+    // 以当前电平为初始状态，之后的变化由中断记录
+    bool pressed = readKey(state);
+    state.lastState = pressed;
+    state.currentState = pressed;
+    isrArgs[index].lib = this;
+    isrArgs[index].pin = pin;
+    isrArgs[index].activeLevel = config.activeLevel;
+    attachInterruptArg(digitalPinToInterrupt(pin), edgeIsr, &isrArgs[index], CHANGE);
+  }
+#endif
+  return true;
+}
+
+bool KeyLib::readKey(const KeyState &state) {
+  if (state.pin >= KEYLIB_VIRTUAL_KEY_BASE) {
+    return (virtualLevels >> (state.pin - KEYLIB_VIRTUAL_KEY_BASE)) & 1;
+  }
+  return readPin(state.pin) == state.activeLevel;
+}
+
+void KeyLib::setHooks(KeyReadFunction readFn, KeyClockFunction millisFn, KeyClockFunction microsFn) {
+  readHook = readFn;
+  millisHook = millisFn;
+  microsHook = microsFn;
+}
+
+int KeyLib::readPin(uint8_t pin) {
+  return readHook != NULL ? readHook(pin) : digitalRead(pin);
+}
+
+unsigned long KeyLib::nowMs() {
+  return millisHook != NULL ? millisHook() : millis();
+}
+
+uint32_t KeyLib::nowUs() {
+  if (microsHook != NULL) return microsHook();
+  if (millisHook != NULL) return millisHook() * 1000;
+  return micros();
 }
 
-void KeyLib::updateKeyState(uint8_t pin) {
+bool KeyLib::addSource(KeyInputSource* source) {
+  if (source == NULL || sourceCount >= KEYLIB_MAX_SOURCES) return false;
+  for (uint8_t i = 0; i < sourceCount; i++) {
+    if (sources[i] == source) return true;
+  }
+  sources[sourceCount++] = source;
+  return true;
+}
+
+void KEYLIB_ISR_ATTR KeyLib::injectKeyLevel(uint8_t key, bool pressed) {
+  if (key < KEYLIB_VIRTUAL_KEY_BASE || key >= KEYLIB_MAX_KEY_IDS) return;
+  uint32_t bit = 1UL << (key - KEYLIB_VIRTUAL_KEY_BASE);
+  // 原子读-改-写：不同输入源可能在不同任务中写入
+  uint32_t old;
+  if (pressed) {
+    old = __atomic_fetch_or(&virtualLevels, bit, __ATOMIC_RELAXED);
+  } else {
+    old = __atomic_fetch_and(&virtualLevels, ~bit, __ATOMIC_RELAXED);
+  }
+  if (((old & bit) != 0) != pressed && wakeCallback != NULL) wakeCallback();
+}
+
+void KeyLib::setWakeCallback(KeyWakeCallback callback) {
+  wakeCallback = callback;
+}
+
+// 到due为止的剩余时间，已到期为0
+static unsigned long remainingUntil(unsigned long due, unsigned long now) {
+  long remaining = (long)(due - now);
+  return remaining > 0 ? (unsigned long)remaining : 0;
+}
+
+unsigned long KeyLib::nextDeadline() {
+  unsigned long now = nowMs();
+  unsigned long next = KEYLIB_NO_DEADLINE;
+  
+  for (uint8_t i = 0; i < sourceCount; i++) {
+    unsigned long interval = sources[i]->pollInterval();
+    if (interval < next) next = interval;
+  }
+  if (interruptMode && edgeHead != edgeTail) return 0;  // 有未处理的边沿
+  if (scanMode) {
+    unsigned long interval = debounceDelay / KEYLIB_SCAN_SAMPLES;
+    if (interval == 0) interval = 1;
+    unsigned long remaining = remainingUntil(lastScanTime + interval, now);
+    if (remaining < next) next = remaining;
+  }
+  
+  for (int i = 0; i < keyCount; i++) {
+    const KeyState &state = keyStates[i];
+    unsigned long remaining;
+    if (!scanMode && !interruptMode && state.pin < KEYLIB_VIRTUAL_KEY_BASE && next > 1) {
+      next = 1;  // 轮询模式需要持续采样
+    }
+    if (!scanMode && state.lastState != state.currentState) {
+      // 正在消抖：电平稳定超过消抖时间后确认
+      remaining = remainingUntil(state.lastDebounceTime + state.debounce + 1, now);
+      if (remaining < next) next = remaining;
+    }
+    unsigned long timeout = gestureTimeout(state);
+    if (timeout != GESTURE_NO_TIMEOUT) {
+      remaining = remainingUntil(state.gestureTime + timeout, now);
+      if (remaining < next) next = remaining;
+    }
+    if (chordPendingSlots & (1UL << i)) {
+      remaining = remainingUntil(state.chordTime + chordWindow, now);
+      if (remaining < next) next = remaining;
+    }
+  }
+  for (uint8_t i = 0; i < chordCount; i++) {
+    if (chords[i].active && !chords[i].fired) {
+      unsigned long remaining = remainingUntil(chords[i].time + chords[i].holdTime, now);
+      if (remaining < next) next = remaining;
+    }
+  }
+  return next;
+}
+
+void KeyLib::setGestureTiming(uint16_t longPressTime, uint16_t doubleClickTime, uint16_t repeatInterval) {
+  defaultLongPressTime = longPressTime;
+  defaultDoubleClickTime = doubleClickTime;
+  defaultRepeatInterval = repeatInterval;
+  for (int i = 0; i < keyCount; i++) {
+    keyStates[i].longPressTime = longPressTime;
+    keyStates[i].doubleClickTime = doubleClickTime;
+    keyStates[i].repeatInterval = repeatInterval;
+    keyStates[i].repeatMinInterval = repeatInterval;
+    keyStates[i].repeatRampTime = 0;
+  }
+}
+
+bool KeyLib::setRepeat(uint8_t pin, uint16_t initialDelay, uint16_t interval, uint16_t minInterval, uint16_t rampTime) {
   int index = getKeyIndex(pin);
+  if (index < 0) return false;
   KeyState &state = keyStates[index];
+  state.longPressTime = initialDelay;
+  state.repeatInterval = interval;
+  state.repeatMinInterval = (minInterval > 0 && minInterval < interval) ? minInterval : interval;
+  state.repeatRampTime = rampTime;
+  return true;
+}
+
+int KeyLib::addChord(uint64_t pinMask, uint16_t holdTime) {
+  if (chordCount >= KEYLIB_MAX_CHORDS) return -1;
+  uint32_t mask = 0;
+  int members = 0;
+  for (uint8_t pin = 0; pin < KEYLIB_MAX_KEY_IDS; pin++) {
+    if (!(pinMask & (1ULL << pin))) continue;
+    int index = getKeyIndex(pin);
+    if (index < 0) return -1;
+    mask |= 1UL << index;
+    members++;
+  }
+  if (members < 2) return -1;
   
-  // 读取当前按键状态 (LOW表示按下，因为使用上拉电阻)
-  bool reading = digitalRead(pin) == LOW;
+  KeyChord &chord = chords[chordCount];
+  chord.mask = mask;
+  chord.holdTime = holdTime;
+  chord.active = false;
+  chord.fired = false;
+  chord.time = 0;
+  chordMemberMask |= mask;
+  return chordCount++;
+}
+
+void KeyLib::setChordWindow(uint16_t window) {
+  chordWindow = window;
+}
+
+void KeyLib::setInterruptMode(bool enable) {
+  interruptMode = enable;
+}
+
+int KeyLib::getKeyIndex(uint8_t pin) {
+  // 直接查表
+  if (pin < KEYLIB_MAX_KEY_IDS && pinSlot[pin] >= 0) return pinSlot[pin];
+  
+  // 未注册：按默认配置(上拉输入，低电平为按下)注册
+  KeyConfig config = {LOW, KEY_PULL_UP, 0};
+  if (!registerKey(pin, config)) return -1;
+  return pinSlot[pin];
+}
+
+#if defined(ARDUINO_ARCH_ESP32)
+void KEYLIB_ISR_ATTR KeyLib::edgeIsr(void* arg) {
+  KeyIsrArg* isrArg = (KeyIsrArg*)arg;
+  isrArg->lib->recordEdge(isrArg->pin, digitalRead(isrArg->pin) == isrArg->activeLevel, micros());
+}
+#endif
+
+void KEYLIB_ISR_ATTR KeyLib::recordEdge(uint8_t pin, bool pressed, uint32_t timeUs) {
+  uint16_t head = edgeHead;
+  uint16_t next = (head + 1) & (KEYLIB_EDGE_BUFFER_SIZE - 1);
+  if (next == edgeTail) {
+    edgeOverflow = true;  // 缓冲区满，处理时重新读取电平，不丢失按键的最终状态
+    return;
+  }
+  edgeBuffer[head].pin = pin;
+  edgeBuffer[head].pressed = pressed;
+  edgeBuffer[head].time = timeUs;
+  __sync_synchronize();  // 先写完数据再发布写入位置
+  edgeHead = next;
+  if (wakeCallback != NULL) wakeCallback();
+}
+
+void KeyLib::applyDebouncedLevel(KeyState &state, bool pressed, unsigned long time) {
+  state.currentState = pressed;
+  uint32_t bit = 1UL << (&state - keyStates);
+  if (pressed) {
+    pressedSlots |= bit;
+  } else {
+    pressedSlots &= ~bit;
+  }
+  if ((chordMemberMask & bit) && !chordInput(state, bit, pressed, time)) return;
+  gestureInput(state, pressed ? GESTURE_PRESS : GESTURE_RELEASE, time);
+}
+
+unsigned long KeyLib::gestureTimeout(const KeyState &state) {
+  switch (state.gesture) {
+    case GESTURE_DOWN:
+    case GESTURE_DOWN2:
+      return state.longPressTime > 0 ? state.longPressTime : GESTURE_NO_TIMEOUT;
+    case GESTURE_UP_WAIT:
+      return state.doubleClickTime; // 0：松开后立即确认单击
+    case GESTURE_LONG: {
+      if (state.repeatInterval == 0) return GESTURE_NO_TIMEOUT;
+      // 按住越久间隔越短：在repeatRampTime内从repeatInterval线性缩短到repeatMinInterval
+      unsigned long held = state.gestureTime - state.repeatStart;
+      if (state.repeatRampTime == 0 || held >= state.repeatRampTime) {
+        return state.repeatRampTime == 0 ? state.repeatInterval : state.repeatMinInterval;
+      }
+      unsigned long span = state.repeatInterval - state.repeatMinInterval;
+      return state.repeatInterval - span * held / state.repeatRampTime;
+    }
+    default:
+      return GESTURE_NO_TIMEOUT;
+  }
+}
+
+void KeyLib::advanceGesture(KeyState &state, unsigned long time) {
+  unsigned long timeout = gestureTimeout(state);
+  while (timeout != GESTURE_NO_TIMEOUT && (long)(time - state.gestureTime) >= (long)timeout) {
+    const GestureTransition &t = gestureTable[state.gesture][GESTURE_TIMEOUT];
+    state.gestureTime += timeout;
+    state.gesture = t.next;
+    if (t.event == KEY_EVENT_LONG_PRESS) state.repeatStart = state.gestureTime;
+    if (t.event != KEY_EVENT_NONE) pushEvent(state, t.event, state.gestureTime);
+    if (t.event == KEY_EVENT_REPEAT && (long)(time - state.gestureTime) >= (long)timeout) {
+      state.gestureTime = time; // 主循环卡顿时不补发积压的重复事件
+    }
+    timeout = gestureTimeout(state);
+  }
+}
+
+void KeyLib::gestureInput(KeyState &state, uint8_t input, unsigned long time) {
+  advanceGesture(state, time);  // 先处理在本次输入之前已到期的超时
+  pushEvent(state, input == GESTURE_PRESS ? KEY_EVENT_PRESS : KEY_EVENT_RELEASE, time);
+  const GestureTransition &t = gestureTable[state.gesture][input];
+  state.gesture = t.next;
+  state.gestureTime = time;
+  if (t.event != KEY_EVENT_NONE) pushEvent(state, t.event, time);
+  advanceGesture(state, time);  // 超时为0的状态(不识别双击时的单击)立即转移
+}
+
+bool KeyLib::chordInput(KeyState &state, uint32_t bit, bool pressed, unsigned long time) {
+  if (pressed) {
+    // 暂缓手势输入，等待其他成员
+    state.chordTime = time;
+    chordPendingSlots |= bit;
+    for (uint8_t i = 0; i < chordCount; i++) {
+      KeyChord &chord = chords[i];
+      // 按当前按下的按键匹配：本次按下是最后一个成员，先按下的成员可以已按住超过组合时间
+      if ((chord.mask & bit) && (pressedSlots & chord.mask) == chord.mask) {
+        // 已交给手势状态机的成员(按住超过组合时间)回到空闲，松开时不再产生单击或长按
+        uint32_t held = chord.mask & ~chordPendingSlots & ~chordSuppressedSlots;
+        while (held) {
+          keyStates[__builtin_ctzl(held)].gesture = GESTURE_IDLE;
+          held &= held - 1;
+        }
+        chordPendingSlots &= ~chord.mask;
+        chordSuppressedSlots |= chord.mask;
+        chord.active = true;
+        chord.fired = false;
+        chord.time = time;
+        serviceChords(time);  // 保持时间为0时立即产生事件
+        break;
+      }
+    }
+    return false;
+  }
+  
+  for (uint8_t i = 0; i < chordCount; i++) {
+    if (chords[i].mask & bit) chords[i].active = false;
+  }
+  if (chordSuppressedSlots & bit) {
+    chordSuppressedSlots &= ~bit;
+    return false;
+  }
+  if (chordPendingSlots & bit) {
+    // 组合时间内松开：补上暂缓的按下，之后按普通按键处理
+    chordPendingSlots &= ~bit;
+    gestureInput(state, GESTURE_PRESS, state.chordTime);
+  }
+  return true;
+}
+
+void KeyLib::serviceChords(unsigned long time) {
+  uint32_t pending = chordPendingSlots;
+  while (pending) {
+    uint8_t slot = __builtin_ctzl(pending);
+    pending &= pending - 1;
+    KeyState &state = keyStates[slot];
+    if ((long)(time - state.chordTime) >= (long)chordWindow) {
+      // 组合时间内没有组成组合键，按单键处理(保留原按下时间，长按计时不受影响)
+      chordPendingSlots &= ~(1UL << slot);
+      gestureInput(state, GESTURE_PRESS, state.chordTime);
+    }
+  }
+  
+  for (uint8_t i = 0; i < chordCount; i++) {
+    KeyChord &chord = chords[i];
+    if (chord.active && !chord.fired && (long)(time - chord.time) >= (long)chord.holdTime) {
+      chord.fired = true;
+      queueEvent(i, KEY_EVENT_CHORD, chord.time + chord.holdTime);
+    }
+  }
+}
+
+void KeyLib::pushEvent(KeyState &state, uint8_t type, unsigned long time) {
+  if (type == KEY_EVENT_CLICK) state.latched |= LATCH_CLICK;
+  else if (type == KEY_EVENT_DOUBLE_CLICK) state.latched |= LATCH_DOUBLE;
+  else if (type == KEY_EVENT_LONG_PRESS) state.latched |= LATCH_LONG;
+  queueEvent(state.pin, type, time);
+}
+
+void KeyLib::queueEvent(uint8_t pin, uint8_t type, unsigned long time) {
+  if (eventCount == KEYLIB_EVENT_QUEUE_SIZE) {
+    // 队列满时丢弃最旧的事件
+    eventHead = (eventHead + 1) % KEYLIB_EVENT_QUEUE_SIZE;
+    eventCount--;
+  }
+  KeyEvent &event = eventQueue[(eventHead + eventCount) % KEYLIB_EVENT_QUEUE_SIZE];
+  event.type = (KeyEventType)type;
+  event.pin = pin;
+  event.time = time;
+  eventCount++;
+}
+
+bool KeyLib::getEvent(KeyEvent &event) {
+  if (eventCount == 0) return false;
+  event = eventQueue[eventHead];
+  eventHead = (eventHead + 1) % KEYLIB_EVENT_QUEUE_SIZE;
+  eventCount--;
+  return true;
+}
+
+void KeyLib::applyEdge(KeyState &state, bool pressed, unsigned long time) {
+  // 上一个电平从lastDebounceTime保持到本边沿，超过消抖时间则先确认它(短按不会因处理延迟而丢失)
+  if (state.lastState != state.currentState && time - state.lastDebounceTime > state.debounce) {
+    applyDebouncedLevel(state, state.lastState, state.lastDebounceTime + state.debounce);
+  }
+  if (pressed != state.lastState) {
+    state.lastDebounceTime = time;
+    state.lastState = pressed;
+  }
+}
+
+void KeyLib::processEdges() {
+  // 微秒时间戳换算为毫秒：用与当前时间的差值换算，不受两个计数器回绕的影响
+  unsigned long nowMs = this->nowMs();
+  uint32_t nowUs = this->nowUs();
+  
+  uint16_t head = edgeHead;
+  __sync_synchronize();
+  while (edgeTail != head) {
+    uint16_t tail = edgeTail;
+    KeyEdge edge = edgeBuffer[tail];
+    edgeTail = (tail + 1) & (KEYLIB_EDGE_BUFFER_SIZE - 1);
+    
+    if (edge.pin < KEYLIB_MAX_PINS && pinSlot[edge.pin] >= 0) {
+      applyEdge(keyStates[pinSlot[edge.pin]], edge.pressed, nowMs - (nowUs - edge.time) / 1000);
+    }
+  }
+  
+  if (edgeOverflow) {
+    // 有边沿被丢弃：以当前电平作为一次新边沿
+    edgeOverflow = false;
+    for (int i = 0; i < keyCount; i++) {
+      applyEdge(keyStates[i], readKey(keyStates[i]), nowMs);
+    }
+  }
+  
+  // 最后一个边沿之后电平保持超过消抖时间的按键，确认其电平
+  for (int i = 0; i < keyCount; i++) {
+    KeyState &state = keyStates[i];
+    if (state.lastState != state.currentState && nowMs - state.lastDebounceTime > state.debounce) {
+      applyDebouncedLevel(state, state.lastState, state.lastDebounceTime + state.debounce);
+    }
+  }
+}
+
+void KeyLib::setScanMode(bool enable) {
+  scanMode = enable;
+}
+
+uint64_t KeyLib::readPressedMask() {
+#if defined(KEYLIB_GPIO_REGISTERS)
+  if (readHook == NULL) {
+    // 一次读取全部GPIO输入，低电平有效的按键取反
+    uint64_t levels = ((uint64_t)GPIO.in1.val << 32) | GPIO.in;
+    uint64_t gpioMask = scanKeyMask & ((1ULL << KEYLIB_MAX_PINS) - 1);
+    return ((~levels ^ scanActiveHighMask) & gpioMask) | (((uint64_t)virtualLevels << KEYLIB_VIRTUAL_KEY_BASE) & scanKeyMask);
+  }
+#endif
+  uint64_t pressed = 0;
+  for (int i = 0; i < keyCount; i++) {
+    if (readKey(keyStates[i])) {
+      pressed |= 1ULL << keyStates[i].pin;
+    }
+  }
+  return pressed;
+}
+
+void KeyLib::scan() {
+  unsigned long now = nowMs();
+  lastScanTime = now;
+  
+  // 垂直计数器：每一位有独立的2位计数器(cnt1:cnt0)，采样与消抖状态不同时计数，
+  // 相同时复位；连续KEYLIB_SCAN_SAMPLES次不同才翻转消抖状态
+  uint64_t changed = scanState ^ readPressedMask();
+  scanCnt0 = ~(scanCnt0 & changed);
+  scanCnt1 = scanCnt0 ^ (scanCnt1 & changed);
+  uint64_t toggle = changed & scanCnt0 & scanCnt1;
+  scanState ^= toggle;
+  scanPressed = toggle & scanState;
+  scanReleased = toggle & ~scanState;
+  
+  if (toggle == 0) return;
+  // 电平在KEYLIB_SCAN_SAMPLES个采样前开始稳定，按键时间记为确认时刻
+  while (toggle) {
+    uint8_t pin = __builtin_ctzll(toggle);
+    toggle &= toggle - 1;
+    KeyState &state = keyStates[pinSlot[pin]];
+    bool pressed = (scanState >> pin) & 1;
+    state.lastState = pressed;
+    applyDebouncedLevel(state, pressed, now);
+  }
+}
+
+uint64_t KeyLib::getPressedMask() {
+  return scanPressed;
+}
+
+uint64_t KeyLib::getReleasedMask() {
+  return scanReleased;
+}
+
+void KeyLib::reseedKey(KeyState &state) {
+  bool pressed = readKey(state);
+  uint64_t bit = 1ULL << state.pin;
+  uint32_t slotBit = 1UL << (&state - keyStates);
+  state.lastState = pressed;
+  state.currentState = pressed;
+  state.lastDebounceTime = nowMs();
+  state.gesture = GESTURE_IDLE;
+  if (pressed) {
+    scanState |= bit;
+    pressedSlots |= slotBit;
+  } else {
+    scanState &= ~bit;
+    pressedSlots &= ~slotBit;
+  }
+  // 垂直计数器回到初始值，组合键不再等待这个按键
+  scanCnt0 |= bit;
+  scanCnt1 |= bit;
+  chordPendingSlots &= ~slotBit;
+  chordSuppressedSlots &= ~slotBit;
+}
+
+void KeyLib::pollKey(KeyState &state) {
+  // 读取当前按键状态 (按配置的有效电平判断是否按下)
+  bool reading = readKey(state);
   
   // 检查按键状态是否发生变化
   if (reading != state.lastState) {
-    state.lastDebounceTime = millis();
+    state.lastDebounceTime = nowMs();
   }
   
   // 如果状态稳定超过消抖时间
-  if ((millis() - state.lastDebounceTime) > debounceDelay) {
+  if ((nowMs() - state.lastDebounceTime) > state.debounce) {
     // 如果当前状态与之前记录的状态不同
     if (reading != state.currentState) {
-      state.currentState = reading;
-      
-      // 按键按下
-      if (state.currentState == true) {
-        state.lastPressTime = millis();
-        state.pressCount++;
-        state.pressHandled = false;
-      } 
-      // 按键释放
-      else {
-        state.lastReleaseTime = millis();
-        if (!state.pressHandled) {
-          state.singlePressDetected = true;
-        }
-      }
+      applyDebouncedLevel(state, reading, nowMs());
     }
   }
   
   state.lastState = reading;
 }
 
-bool KeyLib::singlePress(uint8_t pin) {
-  updateKeyState(pin);
-  int index = getKeyIndex(pin);
-  KeyState &state = keyStates[index];
+void KeyLib::update() {
+  unsigned long now = nowMs();
+  lastUpdateTime = now;
+  updatedOnce = true;
   
-  // 检测到单击并且未处理
-  if (state.singlePressDetected) {
-    state.singlePressDetected = false;
-    state.pressHandled = true;
-    return true;
+  // 输入源先更新虚拟按键电平
+  for (uint8_t i = 0; i < sourceCount; i++) {
+    sources[i]->poll(*this);
+  }
+  
+  // 每个按键每次只采样、消抖一次
+  if (scanMode) {
+    // 扫描模式：到扫描间隔时扫描一次全部按键
+    unsigned long interval = debounceDelay / KEYLIB_SCAN_SAMPLES;
+    if (interval == 0) interval = 1;
+    if (now - lastScanTime >= interval) {
+      scan();
+    }
+  } else if (interruptMode) {
+    // 中断模式：只处理中断记录的边沿，虚拟按键没有中断，仍按轮询消抖
+    processEdges();
+    for (int i = 0; i < keyCount; i++) {
+      if (keyStates[i].pin >= KEYLIB_VIRTUAL_KEY_BASE) pollKey(keyStates[i]);
+    }
+  } else {
+    for (int i = 0; i < keyCount; i++) {
+      pollKey(keyStates[i]);
+    }
   }
   
-  return false;
+  if (chordCount > 0) serviceChords(now);
+  
+  // 没有电平变化时，只检查手势超时(长按、双击间隔、重复)
+  for (int i = 0; i < keyCount; i++) {
+    advanceGesture(keyStates[i], now);
+  }
+}
+
+void KeyLib::updateIfStale() {
+  if (!updatedOnce || nowMs() != lastUpdateTime) {
+    update();
+  }
+}
+
+bool KeyLib::consumeLatch(KeyState &state, uint8_t latch) {
+  if ((state.latched & latch) == 0) return false;
+  state.latched &= ~latch;
+  return true;
+}
+
+bool KeyLib::singlePress(uint8_t pin) {
+  int index = getKeyIndex(pin);
+  if (index < 0) return false;
+  KeyState &state = keyStates[index];
+  updateIfStale();
+  return consumeLatch(state, LATCH_CLICK);
 }
 
 bool KeyLib::doublePress(uint8_t pin, unsigned long doublePressTime) {
-  updateKeyState(pin);
   int index = getKeyIndex(pin);
+  if (index < 0) return false;
   KeyState &state = keyStates[index];
-  
-  // 检查是否在指定时间内有两次按下
-  if (state.pressCount >= 2) {
-    unsigned long timeBetweenPresses = state.lastPressTime - state.lastReleaseTime;
-    if (timeBetweenPresses <= doublePressTime) {
-      state.pressCount = 0;
-      state.pressHandled = true;
-      state.singlePressDetected = false;
-      return true;
-    }
-    
-    // 如果超时，重置计数
-    if ((millis() - state.lastPressTime) > doublePressTime) {
-      state.pressCount = 0;
-    }
-  }
-  
-  return false;
+  state.doubleClickTime = doublePressTime;  // 该按键启用双击识别
+  updateIfStale();
+  return consumeLatch(state, LATCH_DOUBLE);
 }
 
 bool KeyLib::longPress(uint8_t pin, unsigned long longPressTime) {
-  updateKeyState(pin);
   int index = getKeyIndex(pin);
+  if (index < 0) return false;
   KeyState &state = keyStates[index];
-  
-  // 按键当前处于按下状态且持续时间超过长按时间
-  if (state.currentState == true && !state.pressHandled) {
-    if ((millis() - state.lastPressTime) >= longPressTime) {
-      state.pressHandled = true;
-      state.singlePressDetected = false;
-      return true;
-    }
-  }
-  
-  return false;
-}
\ No newline at end of file
+  state.longPressTime = longPressTime;
+  updateIfStale();
+  return consumeLatch(state, LATCH_LONG);
+}
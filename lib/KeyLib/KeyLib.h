@@ -2,42 +2,332 @@
 #define KEYLIB_H
 
 #include <Arduino.h>
+#if defined(ARDUINO_ARCH_ESP32)
+#include "soc/soc_caps.h"
+#endif
+
+#define KEYLIB_EDGE_BUFFER_SIZE 64  // 中断边沿缓冲区大小(必须为2的幂)
+#define KEYLIB_SCAN_SAMPLES 4       // 扫描模式：电平连续相同的采样数(垂直计数器为2位)
+#define KEYLIB_EVENT_QUEUE_SIZE 16  // 按键事件队列长度
+#if defined(SOC_GPIO_PIN_COUNT)
+#define KEYLIB_MAX_PINS SOC_GPIO_PIN_COUNT  // GPIO按键的编号范围(ESP32为GPIO0-39，ESP32-S3为GPIO0-48)
+#else
+#define KEYLIB_MAX_PINS 40
+#endif
+#define KEYLIB_MAX_KEY_IDS 64       // 按键编号范围，KEYLIB_MAX_PINS-63为虚拟按键(由输入源提供电平)
+#define KEYLIB_VIRTUAL_KEY_BASE KEYLIB_MAX_PINS
+#define KEYLIB_MAX_SOURCES 4        // 最多支持的输入源数
+#define KEYLIB_NO_DEADLINE 0xFFFFFFFFUL  // nextDeadline()：只有新的输入才会改变状态
+#define KEYLIB_MAX_CHORDS 8         // 最多支持的组合键数
+
+#if defined(ARDUINO_ARCH_ESP32)
+#define KEYLIB_ISR_ATTR IRAM_ATTR
+#else
+#define KEYLIB_ISR_ATTR
+#endif
+
+// 按键事件类型
+enum KeyEventType {
+  KEY_EVENT_NONE = 0,
+  KEY_EVENT_PRESS,          // 按下(消抖后)
+  KEY_EVENT_RELEASE,        // 释放(消抖后)
+  KEY_EVENT_CLICK,          // 单击(启用双击识别时在双击间隔结束后产生)
+  KEY_EVENT_DOUBLE_CLICK,   // 双击
+  KEY_EVENT_LONG_PRESS,     // 长按(按住达到长按时间时产生，松开后不再产生单击)
+  KEY_EVENT_REPEAT,         // 长按后按住不放的重复事件(可随按住时间加速)
+  KEY_EVENT_CHORD           // 组合键(所有成员按下并保持到设定时间)
+};
+
+// 按键的上下拉方式
+enum KeyPull {
+  KEY_PULL_UP = 0,          // 内部上拉(按键接地)
+  KEY_PULL_DOWN,            // 内部下拉(按键接电源)
+  KEY_PULL_NONE             // 外部上下拉
+};
+
+// 按键配置
+struct KeyConfig {
+  uint8_t activeLevel;      // 按下时的电平(LOW/HIGH)
+  KeyPull pull;             // 上下拉方式
+  uint16_t debounce;        // 消抖时间(毫秒)，0为使用KeyLib的消抖时间
+};
+
+// 按键事件
+struct KeyEvent {
+  KeyEventType type;        // 事件类型
+  uint8_t pin;              // 按键引脚(组合键事件为addChord返回的编号)
+  unsigned long time;       // 事件发生时间(毫秒)
+};
+
+class KeyLib;
+
+// 唤醒回调：有新边沿或虚拟按键电平变化时调用(可能在中断中调用)
+typedef void (*KeyWakeCallback)();
+
+// 读引脚和时钟函数，用于替换digitalRead/millis/micros(测试台用合成波形和虚拟时间驱动KeyLib)
+typedef int (*KeyReadFunction)(uint8_t pin);
+typedef unsigned long (*KeyClockFunction)();
+
+// 按键输入源：电阻分压按键、触摸按键等非GPIO按键，通过虚拟按键编号接入消抖和手势处理
+class KeyInputSource {
+  public:
+    virtual ~KeyInputSource() {}
+
+    // 由KeyLib::update()在读取按键之前调用，通过KeyLib::injectKeyLevel更新虚拟按键电平
+    virtual void poll(KeyLib &keys) = 0;
+
+    // 空闲时poll()至少多久调用一次(毫秒)；电平变化由injectKeyLevel通知时返回KEYLIB_NO_DEADLINE
+    virtual unsigned long pollInterval() { return 1; }
+};
 
 class KeyLib {
   private:
     // 存储按键状态的变量
     struct KeyState {
-      bool lastState;           // 上一次按键状态
-      bool currentState;        // 当前按键状态
-      unsigned long lastDebounceTime;  // 上次消抖时间
-      unsigned long lastPressTime;     // 上次按下时间
-      unsigned long lastReleaseTime;   // 上次释放时间
-      bool pressHandled;        // 按键是否已处理
-      bool singlePressDetected; // 单击检测标志
-      int pressCount;           // 按下计数(用于双击)
+      uint8_t pin;              // 按键引脚
+      uint8_t activeLevel;      // 按下时的电平
+      uint16_t debounce;        // 消抖时间(毫秒)
+      bool lastState;           // 上一次采样状态(未消抖)
+      bool currentState;        // 消抖后的状态
+      unsigned long lastDebounceTime;  // 上次电平变化时间
+      uint8_t gesture;          // 手势状态机的当前状态
+      uint8_t latched;          // 锁存的手势(供singlePress/doublePress/longPress查询)
+      unsigned long gestureTime;       // 进入当前手势状态的时间
+      uint16_t longPressTime;   // 长按时间(毫秒)，0为不识别长按
+      uint16_t doubleClickTime; // 双击间隔(毫秒)，0为不识别双击(松开即为单击)
+      uint16_t repeatInterval;  // 长按后重复事件的间隔(毫秒)，0为不重复
+      uint16_t repeatMinInterval;      // 加速后的最短重复间隔(毫秒)
+      uint16_t repeatRampTime;  // 从repeatInterval缩短到repeatMinInterval所需的按住时间(毫秒)，0为不加速
+      unsigned long repeatStart;       // 开始重复(产生长按事件)的时间
+      unsigned long chordTime;  // 等待组合键时记录的按下时间
+    };
+
+    // 组合键
+    struct KeyChord {
+      uint32_t mask;            // 成员按键(按keyStates下标的位掩码)
+      uint16_t holdTime;        // 需保持的时间(毫秒)
+      bool active;              // 所有成员已按下，等待保持时间
+      bool fired;               // 本次按下已产生事件
+      unsigned long time;       // 所有成员按下的时间
+    };
+
+    // 中断模式下记录的边沿
+    struct KeyEdge {
+      uint8_t pin;              // 引脚
+      bool pressed;             // 边沿之后是否为按下电平
+      uint32_t time;            // 时间戳(微秒)
+    };
+
+    // 传给中断服务函数的参数
+    struct KeyIsrArg {
+      KeyLib* lib;
+      uint8_t pin;
+      uint8_t activeLevel;
     };
 
     // 按键状态映射
-    static const int MAX_KEYS = 10;  // 最多支持的按键数
+    static const int MAX_KEYS = 32;  // 最多支持的按键数
     KeyState keyStates[MAX_KEYS];
     int keyCount;
+    int8_t pinSlot[KEYLIB_MAX_KEY_IDS];  // 按键编号→keyStates下标，-1为未注册
+
+    // 虚拟按键：输入源写入的按下状态(第n位对应编号KEYLIB_VIRTUAL_KEY_BASE+n)
+    volatile uint32_t virtualLevels;
+    KeyInputSource* sources[KEYLIB_MAX_SOURCES];
+    uint8_t sourceCount;
+
+    // 有新输入时调用，用于唤醒阻塞等待的输入任务
+    KeyWakeCallback wakeCallback;
+
+    // 替换的读引脚和时钟函数，NULL为使用digitalRead/millis/micros
+    KeyReadFunction readHook;
+    KeyClockFunction millisHook;
+    KeyClockFunction microsHook;
 
     // 消抖时间(毫秒)
     unsigned long debounceDelay;
 
-    // 查找或创建按键状态
+    // 新注册按键的手势时间
+    uint16_t defaultLongPressTime;
+    uint16_t defaultDoubleClickTime;
+    uint16_t defaultRepeatInterval;
+
+    // 组合键：按键状态按keyStates下标打包成位掩码，匹配只需一次与运算和比较
+    KeyChord chords[KEYLIB_MAX_CHORDS];
+    uint8_t chordCount;
+    uint16_t chordWindow;           // 成员按下的最大时间差(毫秒)
+    uint32_t chordMemberMask;       // 属于任一组合键的按键
+    uint32_t pressedSlots;          // 消抖后按下的按键(组合键按它匹配)
+    uint32_t chordPendingSlots;     // 已按下、还在等待组合的按键(手势输入暂缓)
+    uint32_t chordSuppressedSlots;  // 已组成组合键的按键，松开前不产生单键事件
+
+    // 事件队列(满时丢弃最旧的事件)
+    KeyEvent eventQueue[KEYLIB_EVENT_QUEUE_SIZE];
+    uint8_t eventHead;
+    uint8_t eventCount;
+
+    // 上次update()的时间，旧接口在同一毫秒内不重复更新
+    unsigned long lastUpdateTime;
+    bool updatedOnce;
+
+    // 中断模式：中断写入、主循环读取的无锁环形缓冲区
+    bool interruptMode;
+    KeyEdge edgeBuffer[KEYLIB_EDGE_BUFFER_SIZE];
+    volatile uint16_t edgeHead;     // 写入位置(只由中断修改)
+    volatile uint16_t edgeTail;     // 读取位置(只由主循环修改)
+    volatile bool edgeOverflow;     // 缓冲区满时置位，处理时重新读取所有按键电平
+    KeyIsrArg isrArgs[MAX_KEYS];
+
+    // 扫描模式：所有按键按GPIO编号打包成64位掩码，一次读寄存器、一次字运算完成消抖
+    bool scanMode;
+    uint64_t scanKeyMask;           // 已注册按键的掩码
+    uint64_t scanActiveHighMask;    // 高电平为按下的按键的掩码
+    uint64_t scanState;             // 消抖后的按下状态
+    uint64_t scanCnt0;              // 垂直计数器低位
+    uint64_t scanCnt1;              // 垂直计数器高位
+    uint64_t scanPressed;           // 最近一次扫描中新按下的按键
+    uint64_t scanReleased;          // 最近一次扫描中新释放的按键
+    unsigned long lastScanTime;     // 上次扫描时间(毫秒)
+
+    // 查找按键状态，未注册时按默认配置注册；引脚无效或按键已满时返回-1
     int getKeyIndex(uint8_t pin);
+
+    // 读取一个按键当前是否按下(未消抖)
+    bool readKey(const KeyState &state);
+
+    // 读引脚电平和当前时间(经过替换函数)
+    int readPin(uint8_t pin);
+    unsigned long nowMs();
+    uint32_t nowUs();
     
-    // 更新按键状态
-    void updateKeyState(uint8_t pin);
+    // 轮询模式下读取并消抖一个按键
+    void pollKey(KeyState &state);
+
+    // 以当前电平重新建立按键的消抖状态(修改有效电平后)，手势回到松开状态，不产生事件
+    void reseedKey(KeyState &state);
+
+    // 确认消抖后的电平变化，time为电平稳定的时间(毫秒)
+    void applyDebouncedLevel(KeyState &state, bool pressed, unsigned long time);
+
+    // 按时间戳处理缓冲区中的边沿，并确认已稳定的电平
+    void processEdges();
+
+    // 对一个按键处理一个边沿
+    void applyEdge(KeyState &state, bool pressed, unsigned long time);
+
+    // 读取所有按键的按下状态(按GPIO编号的位掩码)
+    uint64_t readPressedMask();
+
+    // 手势状态机：处理按下/释放/超时输入
+    void gestureInput(KeyState &state, uint8_t input, unsigned long time);
+
+    // 手势状态机：触发到time为止已到期的超时
+    void advanceGesture(KeyState &state, unsigned long time);
+
+    // 当前手势状态的超时时间
+    unsigned long gestureTimeout(const KeyState &state);
+
+    // 产生一个事件并锁存对应的手势
+    void pushEvent(KeyState &state, uint8_t type, unsigned long time);
+
+    // 把事件放入队列
+    void queueEvent(uint8_t pin, uint8_t type, unsigned long time);
+
+    // 组合键成员的电平变化，返回false表示该输入被组合键暂缓或吸收
+    bool chordInput(KeyState &state, uint32_t bit, bool pressed, unsigned long time);
+
+    // 把等待超过组合时间的按键交给手势状态机，并检查组合键的保持时间
+    void serviceChords(unsigned long time);
+
+    // 旧接口使用：本毫秒内还没有更新过时调用update()
+    void updateIfStale();
+
+    // 取出并清除锁存的手势
+    bool consumeLatch(KeyState &state, uint8_t latch);
+
+#if defined(ARDUINO_ARCH_ESP32)
+    // GPIO边沿中断服务函数
+    static void KEYLIB_ISR_ATTR edgeIsr(void* arg);
+#endif
 
   public:
     KeyLib(unsigned long debounceTime = 50);
     
-    // 检测单击
+    // 注册按键(上拉输入，低电平为按下)；检测函数会自动注册，使用事件队列时需先注册
+    bool registerKey(uint8_t pin);
+
+    // 按配置注册按键，已注册的按键更新配置；引脚无效或按键已满时返回false
+    // 修改有效电平时以当前电平重新开始消抖；编号KEYLIB_VIRTUAL_KEY_BASE(ESP32为40)-63为虚拟按键，
+    // 不配置引脚，电平由injectKeyLevel提供(忽略有效电平和上下拉)
+    bool registerKey(uint8_t pin, const KeyConfig &config);
+
+    // 添加输入源，update()每次先调用它的poll()
+    bool addSource(KeyInputSource* source);
+
+    // 设置虚拟按键的按下状态(未消抖)，可在其他任务、定时器回调或中断中调用(ESP32上放在IRAM中)
+    void KEYLIB_ISR_ATTR injectKeyLevel(uint8_t key, bool pressed);
+
+    // 设置手势时间，作用于已注册和之后注册的所有按键
+    // doubleClickTime为0时不识别双击，单击在松开时立即产生；repeatInterval为0时不产生重复事件
+    void setGestureTiming(uint16_t longPressTime, uint16_t doubleClickTime = 0, uint16_t repeatInterval = 0);
+
+    // 注册组合键，pinMask的第n位对应按键编号n(至少两个按键)
+    // 所有成员都处于按下状态并保持holdTime后产生KEY_EVENT_CHORD，成员以任意顺序按下；
+    // 先按下的成员可以按住任意时间(如按住SELECT再按另一个键)，此时它已产生的单键按下事件不撤回
+    // 成员按下后暂缓组合时间再产生单键事件，组合时间内按齐则不产生；组成组合键后直到松开都不产生单键事件
+    // 组合键按注册顺序匹配，包含关系的组合键应先注册成员多的
+    // 返回组合键编号，失败返回-1
+    int addChord(uint64_t pinMask, uint16_t holdTime = 0);
+
+    // 设置组合时间(成员按下后暂缓单键事件的时间，毫秒)
+    void setChordWindow(uint16_t window);
+
+    // 设置按住连发：按住initialDelay后产生长按事件，之后每隔interval产生一次重复事件；
+    // 按住时间越长间隔越短，在rampTime内线性缩短到minInterval(rampTime为0时不加速)
+    // 重复事件带时间戳，可直接作为导航输入(如MenuSystem::postInput)，由菜单按速度合并为多项跳转
+    bool setRepeat(uint8_t pin, uint16_t initialDelay, uint16_t interval, uint16_t minInterval = 0, uint16_t rampTime = 0);
+
+    // 设置唤醒回调：中断记录到边沿或虚拟按键电平变化时调用(在中断中调用时需放在IRAM中)
+    void setWakeCallback(KeyWakeCallback callback);
+
+    // 替换读引脚和时钟函数(传NULL恢复digitalRead/millis/micros)；microsFn为NULL时由millisFn换算
+    // 替换后扫描模式也通过readFn读取，中断模式下硬件中断仍使用真实的引脚和时间
+    void setHooks(KeyReadFunction readFn, KeyClockFunction millisFn, KeyClockFunction microsFn = NULL);
+
+    // 距离下次必须调用update()的时间(毫秒)：消抖确认、手势超时、组合键、扫描和输入源轮询中最早的一个
+    // 0为应立即调用；KEYLIB_NO_DEADLINE为只有新输入才需要调用(中断模式且没有待处理的计时)
+    // 轮询模式下的GPIO按键需要持续采样，返回1
+    unsigned long nextDeadline();
+
+    // 读取输入、消抖并运行所有按键的手势状态机，每次主循环调用一次
+    void update();
+
+    // 取出一个按键事件，没有事件时返回false
+    bool getEvent(KeyEvent &event);
+
+    // 启用/关闭中断模式(需在第一次检测按键之前调用)
+    // 中断模式下按键边沿由中断带时间戳记录，检测函数只处理记录的边沿，不再轮询引脚
+    // ESP32上自动挂接GPIO中断；其他平台需由外部调用recordEdge提供边沿
+    void setInterruptMode(bool enable);
+
+    // 记录一个按键边沿(由中断调用；也可用于注入测试输入)
+    void KEYLIB_ISR_ATTR recordEdge(uint8_t pin, bool pressed, uint32_t timeUs);
+
+    // 启用/关闭扫描模式：每隔 消抖时间/KEYLIB_SCAN_SAMPLES 读一次GPIO输入寄存器，
+    // 所有按键并行消抖，扫描开销与按键数无关(所有按键使用KeyLib的消抖时间)
+    void setScanMode(bool enable);
+
+    // 立即扫描一次(扫描模式下update()会按间隔自动调用)
+    void scan();
+
+    // 最近一次扫描中新按下/新释放的按键(第n位对应GPIOn)
+    uint64_t getPressedMask();
+    uint64_t getReleasedMask();
+    
+    // 检测单击(由手势状态机锁存，与doublePress/longPress同时使用时互不干扰)
     bool singlePress(uint8_t pin);
     
-    // 检测双击
+    // 检测双击(调用后该按键启用双击识别，单击延迟到双击间隔结束后产生)
     bool doublePress(uint8_t pin, unsigned long doublePressTime = 300);
     
     // 检测长按
@@ -0,0 +1,155 @@
+#include "LadderKeys.h"
+#if defined(ARDUINO_ARCH_ESP32)
+#include "esp_idf_version.h"
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 4, 0)
+#include "driver/adc.h"
+#include "soc/soc_caps.h"
+#define LADDER_ADC_DMA  // ADC连续模式(DMA)
+#endif
+#endif
+
+LadderKeys::LadderKeys(uint8_t adcPin, uint8_t firstKey) {
+  this->adcPin = adcPin;
+  this->firstKey = firstKey;
+  bands = NULL;
+  bandCount = 0;
+  currentBand = -1;
+  sample = 0;
+  running = false;
+  replaySamples = NULL;
+  replayCount = 0;
+  replayInterval = 1;
+  replayStart = 0;
+}
+
+void LadderKeys::setBands(const LadderBand* bands, uint8_t count) {
+  this->bands = bands;
+  bandCount = count > LADDER_MAX_BANDS ? LADDER_MAX_BANDS : count;
+}
+
+bool LadderKeys::begin(KeyLib &keys) {
+  if (bands == NULL || bandCount == 0) return false;
+  for (uint8_t i = 0; i < bandCount; i++) {
+    if (!keys.registerKey(firstKey + i)) return false;
+  }
+  keys.addSource(this);
+  if (running) return true;
+
+#if defined(LADDER_ADC_DMA)
+  int channel = digitalPinToAnalogChannel(adcPin);
+  if (channel < 0 || channel >= SOC_ADC_CHANNEL_NUM(0)) return false;  // 连续模式只支持ADC1
+
+  adc_digi_init_config_t init = {};
+  init.max_store_buf_size = LADDER_READ_BYTES * 4;
+  init.conv_num_each_intr = LADDER_READ_BYTES;
+  init.adc1_chan_mask = 1 << channel;
+  init.adc2_chan_mask = 0;
+  if (adc_digi_initialize(&init) != ESP_OK) return false;
+
+  adc_digi_pattern_config_t pattern = {};
+  pattern.atten = ADC_ATTEN_DB_11;  // 满量程约3.1V
+  pattern.channel = channel;
+  pattern.unit = 0;                 // ADC1
+  pattern.bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+
+  adc_digi_configuration_t config = {};
+  config.conv_limit_en = true;
+  config.conv_limit_num = 250;
+  config.pattern_num = 1;
+  config.adc_pattern = &pattern;
+  config.sample_freq_hz = LADDER_SAMPLE_RATE;
+  config.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+  config.format = ADC_DIGI_OUTPUT_FORMAT_TYPE1;
+  if (adc_digi_controller_configure(&config) != ESP_OK || adc_digi_start() != ESP_OK) {
+    adc_digi_deinitialize();
+    return false;
+  }
+#endif
+
+  running = true;
+  return true;
+}
+
+void LadderKeys::end() {
+  if (!running) return;
+#if defined(LADDER_ADC_DMA)
+  adc_digi_stop();
+  adc_digi_deinitialize();
+#endif
+  running = false;
+}
+
+void LadderKeys::replay(const uint16_t* samples, size_t count, uint16_t intervalMs) {
+  replaySamples = count > 0 ? samples : NULL;
+  replayCount = count;
+  replayInterval = intervalMs > 0 ? intervalMs : 1;
+  replayStart = millis();
+}
+
+uint16_t LadderKeys::lastSample() {
+  return sample;
+}
+
+bool LadderKeys::readSample(uint16_t &value) {
+  if (replaySamples != NULL) {
+    // 回放：按经过的时间取采样，结束后保持最后一个值
+    size_t index = (millis() - replayStart) / replayInterval;
+    if (index >= replayCount) index = replayCount - 1;
+    value = replaySamples[index];
+    return true;
+  }
+
+#if defined(LADDER_ADC_DMA)
+  // 取出DMA中已有的全部数据，两个缓冲区轮流接收，较旧的批次不解码，只对最新一批求平均；超时为0，不等待
+  uint8_t buffers[2][LADDER_READ_BYTES];
+  uint8_t current = 0;
+  uint32_t latestLength = 0;
+  for (;;) {
+    uint32_t length = 0;
+    esp_err_t ret = adc_digi_read_bytes(buffers[current], LADDER_READ_BYTES, &length, 0);
+    // ESP_ERR_INVALID_STATE表示缓冲池曾满、丢弃过旧数据，读出的数据仍然有效
+    if ((ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) || length == 0) break;
+    latestLength = length;
+    current ^= 1;
+  }
+  const uint8_t* latest = buffers[current ^ 1];
+  uint32_t sum = 0;
+  uint32_t count = 0;
+  for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= latestLength; i += SOC_ADC_DIGI_RESULT_BYTES) {
+    const adc_digi_output_data_t* data = (const adc_digi_output_data_t*)&latest[i];
+    sum += data->type1.data;
+    count++;
+  }
+  if (count == 0) return false;
+  value = sum / count;
+  return true;
+#else
+  value = analogRead(adcPin);
+  return true;
+#endif
+}
+
+int8_t LadderKeys::classify(uint16_t value) {
+  for (uint8_t i = 0; i < bandCount; i++) {
+    if (value >= bands[i].low && value <= bands[i].high) return i;
+  }
+  return -1;
+}
+
+unsigned long LadderKeys::pollInterval() {
+  return running ? LADDER_POLL_INTERVAL : KEYLIB_NO_DEADLINE;
+}
+
+void LadderKeys::poll(KeyLib &keys) {
+  if (!running) return;
+  uint16_t value;
+  if (!readSample(value)) return;
+  sample = value;
+
+  // 同一时刻只有一个区间有效，换算为虚拟按键电平；区间之间的过渡由KeyLib消抖滤除
+  int8_t band = classify(value);
+  if (band == currentBand) return;
+  if (currentBand >= 0) keys.injectKeyLevel(firstKey + currentBand, false);
+  if (band >= 0) keys.injectKeyLevel(firstKey + band, true);
+  currentBand = band;
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#ifndef LADDERKEYS_H
+#define LADDERKEYS_H
+
+#include <Arduino.h>
+#include "KeyLib.h"
+
+#define LADDER_MAX_BANDS 8          // 一个ADC引脚上最多的按键数
+#define LADDER_SAMPLE_RATE 20000    // 连续采样频率(Hz)，ESP32的ADC DMA最低为20kHz
+#define LADDER_READ_BYTES 256       // 每次从DMA读取的字节数
+#define LADDER_POLL_INTERVAL 10     // 空闲时读取DMA缓冲区的间隔(毫秒)
+
+// 电压区间：采样值(12位原始值)落在[low, high]内时对应的按键按下
+struct LadderBand {
+  uint16_t low;
+  uint16_t high;
+};
+
+// 电阻分压按键：多个按键通过电阻分压接在同一个ADC引脚上
+// ESP32上ADC以连续模式由DMA采样，不占用CPU；poll()只取出DMA缓冲区中最新的一批采样求平均，
+// 按区间表换算为虚拟按键的按下状态，之后与GPIO按键一样消抖并产生手势事件
+// 注意：ESP32的ADC连续模式使用I2S0，不能与ToneSynth同时使用
+class LadderKeys : public KeyInputSource {
+  public:
+    // adcPin必须是ADC1的引脚(GPIO32-39)，第i个区间对应虚拟按键firstKey+i
+    LadderKeys(uint8_t adcPin, uint8_t firstKey = KEYLIB_VIRTUAL_KEY_BASE);
+
+    // 设置电压区间表(按键松开时的电压不应落在任何区间内)，数组需在使用期间保持有效
+    void setBands(const LadderBand* bands, uint8_t count);
+
+    // 注册虚拟按键并启动ADC连续采样，成功返回true
+    bool begin(KeyLib &keys);
+
+    // 停止采样
+    void end();
+
+    // 回放记录的采样值(用于主机测试或在设备上复现问题)，按intervalMs的间隔依次作为电压读数，
+    // 回放期间不读ADC；samples为NULL时结束回放
+    void replay(const uint16_t* samples, size_t count, uint16_t intervalMs);
+
+    // 最近一次的平均采样值
+    uint16_t lastSample();
+
+    // 由KeyLib::update()调用
+    void poll(KeyLib &keys);
+
+    // 空闲时每LADDER_POLL_INTERVAL毫秒读取一次
+    unsigned long pollInterval();
+
+  private:
+    uint8_t adcPin;
+    uint8_t firstKey;
+    const LadderBand* bands;
+    uint8_t bandCount;
+    int8_t currentBand;             // 当前按下的区间，-1为都没有按下
+    uint16_t sample;                // 最近一次的平均采样值
+    bool running;
+
+    // 回放
+    const uint16_t* replaySamples;
+    size_t replayCount;
+    uint16_t replayInterval;
+    unsigned long replayStart;
+
+    // 读取最新的采样值，没有新数据时返回false
+    bool readSample(uint16_t &value);
+
+    // 采样值所在的区间，不在任何区间内时返回-1
+    int8_t classify(uint16_t value);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,172 @@
+#include "RotaryEncoder.h"
+#if defined(ARDUINO_ARCH_ESP32)
+#include "driver/pcnt.h"
+#endif
+
+RotaryEncoder::RotaryEncoder(uint8_t pinA, uint8_t pinB, EncoderStepMode mode, uint8_t unit) {
+  this->pinA = pinA;
+  this->pinB = pinB;
+  this->unit = unit;
+  stepMode = mode;
+  filter = ENCODER_FILTER_DEFAULT;
+  callback = NULL;
+  activityCallback = NULL;
+  running = false;
+  overflow = 0;
+  consumed = 0;
+  position = 0;
+}
+
+bool RotaryEncoder::begin() {
+  if (running) return true;
+  pinMode(pinA, INPUT_PULLUP);
+  pinMode(pinB, INPUT_PULLUP);
+
+#if defined(ARDUINO_ARCH_ESP32)
+  pcnt_unit_t pcnt = (pcnt_unit_t)unit;
+  // 两个通道互为脉冲和控制信号，A、B的每个边沿都计数(4倍频)，方向由另一相的电平决定
+  pcnt_config_t config = {};
+  config.pulse_gpio_num = pinA;
+  config.ctrl_gpio_num = pinB;
+  config.channel = PCNT_CHANNEL_0;
+  config.unit = pcnt;
+  config.pos_mode = PCNT_COUNT_DEC;
+  config.neg_mode = PCNT_COUNT_INC;
+  config.lctrl_mode = PCNT_MODE_REVERSE;
+  config.hctrl_mode = PCNT_MODE_KEEP;
+  config.counter_h_lim = ENCODER_COUNTER_LIMIT;
+  config.counter_l_lim = -ENCODER_COUNTER_LIMIT;
+  if (pcnt_unit_config(&config) != ESP_OK) return false;
+
+  config.pulse_gpio_num = pinB;
+  config.ctrl_gpio_num = pinA;
+  config.channel = PCNT_CHANNEL_1;
+  config.pos_mode = PCNT_COUNT_INC;
+  config.neg_mode = PCNT_COUNT_DEC;
+  if (pcnt_unit_config(&config) != ESP_OK) return false;
+
+  if (filter > 0) {
+    pcnt_set_filter_value(pcnt, filter);
+    pcnt_filter_enable(pcnt);
+  }
+  pcnt_counter_pause(pcnt);
+  pcnt_counter_clear(pcnt);
+
+  // 计数器到达上下限时清零，在中断中累加，总计数不受16位计数器范围限制
+  pcnt_event_enable(pcnt, PCNT_EVT_H_LIM);
+  pcnt_event_enable(pcnt, PCNT_EVT_L_LIM);
+  esp_err_t ret = pcnt_isr_service_install(0);
+  if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) return false;  // 已安装时返回INVALID_STATE
+  pcnt_isr_handler_add(pcnt, limitIsr, this);
+  pcnt_counter_resume(pcnt);
+
+  if (activityCallback != NULL) {
+    // GPIO中断与PCNT可同时使用同一引脚，只用于唤醒，计数仍由PCNT完成
+    attachInterrupt(digitalPinToInterrupt(pinA), activityCallback, CHANGE);
+    attachInterrupt(digitalPinToInterrupt(pinB), activityCallback, CHANGE);
+  }
+#endif
+
+  overflow = 0;
+  consumed = 0;
+  running = true;
+  return true;
+}
+
+void RotaryEncoder::end() {
+  if (!running) return;
+#if defined(ARDUINO_ARCH_ESP32)
+  pcnt_counter_pause((pcnt_unit_t)unit);
+  pcnt_isr_handler_remove((pcnt_unit_t)unit);
+  if (activityCallback != NULL) {
+    detachInterrupt(digitalPinToInterrupt(pinA));
+    detachInterrupt(digitalPinToInterrupt(pinB));
+  }
+#endif
+  running = false;
+}
+
+void RotaryEncoder::setStepMode(EncoderStepMode mode) {
+  stepMode = mode;
+  consumed = readCounts();
+}
+
+void RotaryEncoder::setFilter(uint16_t cycles) {
+  filter = cycles > 1023 ? 1023 : cycles;
+#if defined(ARDUINO_ARCH_ESP32)
+  if (!running) return;  // begin()时再配置
+  if (filter > 0) {
+    pcnt_set_filter_value((pcnt_unit_t)unit, filter);
+    pcnt_filter_enable((pcnt_unit_t)unit);
+  } else {
+    pcnt_filter_disable((pcnt_unit_t)unit);
+  }
+#endif
+}
+
+void RotaryEncoder::onRotate(EncoderCallback callback) {
+  this->callback = callback;
+}
+
+void RotaryEncoder::onActivity(KeyWakeCallback callback) {
+  activityCallback = callback;
+}
+
+unsigned long RotaryEncoder::pollInterval() {
+#if defined(ARDUINO_ARCH_ESP32)
+  if (activityCallback != NULL) return KEYLIB_NO_DEADLINE;
+#endif
+  return 1;
+}
+
+#if defined(ARDUINO_ARCH_ESP32)
+void RotaryEncoder::limitIsr(void* arg) {
+  RotaryEncoder* self = (RotaryEncoder*)arg;
+  uint32_t status = 0;
+  pcnt_get_event_status((pcnt_unit_t)self->unit, &status);
+  if (status & PCNT_EVT_H_LIM) {
+    self->overflow += ENCODER_COUNTER_LIMIT;
+  } else if (status & PCNT_EVT_L_LIM) {
+    self->overflow -= ENCODER_COUNTER_LIMIT;
+  }
+}
+#endif
+
+int32_t RotaryEncoder::readCounts() {
+#if defined(ARDUINO_ARCH_ESP32)
+  if (running) {
+    // 读计数期间可能发生溢出中断，前后两次累加值相同时读数才一致
+    int32_t before;
+    int16_t count;
+    do {
+      before = overflow;
+      pcnt_get_counter_value((pcnt_unit_t)unit, &count);
+    } while (before != overflow);
+    return before + count;
+  }
+#endif
+  return overflow;
+}
+
+void RotaryEncoder::injectCounts(int32_t counts) {
+  overflow += counts;
+}
+
+int16_t RotaryEncoder::update() {
+  int32_t pending = readCounts() - consumed;
+  // 向零取整，不足一档的计数留到下次
+  int16_t delta = pending / stepMode;
+  if (delta == 0) return 0;
+  consumed += (int32_t)delta * stepMode;
+  position += delta;
+  if (callback != NULL) callback(delta, millis());
+  return delta;
+}
+
+long RotaryEncoder::getPosition() {
+  return position;
+}
+
+void RotaryEncoder::poll(KeyLib &keys) {
+  update();
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+#ifndef ROTARYENCODER_H
+#define ROTARYENCODER_H
+
+#include <Arduino.h>
+#include "KeyLib.h"
+
+#define ENCODER_COUNTER_LIMIT 16384   // PCNT计数器上下限，到达时在中断中累加并清零
+#define ENCODER_FILTER_DEFAULT 1023   // 默认毛刺滤波(APB时钟周期，80MHz下约12.8us)
+
+// 每个定位档对应的正交计数
+enum EncoderStepMode {
+  ENCODER_FULL_STEP = 4,      // 每档一个完整正交周期(最常见)
+  ENCODER_HALF_STEP = 2,      // 每档半个周期
+  ENCODER_QUARTER_STEP = 1    // 每个边沿都算一档
+};
+
+// 旋转回调：delta为转过的档数(方向与A、B接线有关，反了时交换两个引脚)，timestamp为读到变化的时间(毫秒)
+typedef void (*EncoderCallback)(int16_t delta, unsigned long timestamp);
+
+// 旋转编码器：ESP32上由PCNT以4倍频正交解码，硬件毛刺滤波，计数不占用CPU、快速旋转不丢步
+// update()读取计数并按档位换算，不足一档的计数保留到下次；作为KeyLib的输入源时由KeyLib::update()调用
+class RotaryEncoder : public KeyInputSource {
+  public:
+    RotaryEncoder(uint8_t pinA, uint8_t pinB, EncoderStepMode mode = ENCODER_FULL_STEP, uint8_t unit = 0);
+
+    // 配置PCNT单元并开始计数，成功返回true
+    bool begin();
+
+    // 停止计数
+    void end();
+
+    // 设置档位模式(不足一档的计数清零)
+    void setStepMode(EncoderStepMode mode);
+
+    // 设置毛刺滤波，短于cycles个APB时钟周期的脉冲被忽略(最大1023)，0为关闭
+    void setFilter(uint16_t cycles);
+
+    // 设置旋转回调(如直接调用MenuSystem::navigate)
+    void onRotate(EncoderCallback callback);
+
+    // 设置活动回调：A、B相有边沿时在中断中调用(需放在IRAM中)，用于唤醒阻塞等待的输入任务；需在begin()之前调用
+    // 设置后空闲时不需要轮询编码器
+    void onActivity(KeyWakeCallback callback);
+
+    // 读取计数，有整档变化时调用回调，返回转过的档数
+    int16_t update();
+
+    // 累计位置(档)
+    long getPosition();
+
+    // 注入正交计数(用于没有PCNT的平台或测试)
+    void injectCounts(int32_t counts);
+
+    // 由KeyLib::update()调用
+    void poll(KeyLib &keys);
+
+    // 设置了活动回调时不需要轮询，否则每毫秒读取一次
+    unsigned long pollInterval();
+
+  private:
+    uint8_t pinA;
+    uint8_t pinB;
+    uint8_t unit;
+    uint8_t stepMode;
+    uint16_t filter;
+    EncoderCallback callback;
+    KeyWakeCallback activityCallback;
+    bool running;
+    volatile int32_t overflow;      // 计数器到达上下限时累加的计数
+    int32_t consumed;               // 已换算为档位的计数
+    long position;
+
+    // 当前的总计数
+    int32_t readCounts();
+
+#if defined(ARDUINO_ARCH_ESP32)
+    // 计数器到达上下限的中断
+    static void limitIsr(void* arg);
+#endif
+};
+
+#endif
\ No newline at end of file
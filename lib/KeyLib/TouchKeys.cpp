@@ -0,0 +1,187 @@
+#include "TouchKeys.h"
+
+#if defined(SOC_TOUCH_VERSION_2)
+#define TOUCH_KEYS_RISING  // ESP32-S2/S3：触摸时读数增大；ESP32：触摸时读数减小
+#endif
+#if defined(TOUCH_KEYS_HW)
+#include "driver/touch_pad.h"
+#endif
+
+TouchKeys::TouchKeys(uint8_t firstKey) {
+  this->firstKey = firstKey;
+  padCount = 0;
+  sensitivity = 20;
+  keys = NULL;
+  running = false;
+#if defined(TOUCH_KEYS_HW)
+  timer = NULL;
+#endif
+}
+
+int TouchKeys::addPad(uint8_t pin) {
+  if (running || padCount >= TOUCH_MAX_PADS) return -1;
+#if defined(TOUCH_KEYS_HW)
+  if (digitalPinToTouchChannel(pin) < 0) return -1;
+#endif
+  TouchPad &pad = pads[padCount];
+  pad.owner = this;
+  pad.index = padCount;
+  pad.pin = pin;
+  pad.baseline = 0;
+  pad.threshold = 0;
+  pad.attached = false;
+  pad.touched = false;
+  pad.isrTouched = 0;
+  return padCount++;
+}
+
+void TouchKeys::setSensitivity(uint8_t percent) {
+  sensitivity = percent > 0 ? percent : 1;
+}
+
+bool TouchKeys::begin(KeyLib &keys) {
+  if (padCount == 0) return false;
+  for (uint8_t i = 0; i < padCount; i++) {
+    if (!keys.registerKey(firstKey + i)) return false;
+  }
+  keys.addSource(this);
+  this->keys = &keys;
+  if (running) return true;
+
+#if defined(TOUCH_KEYS_HW)
+  // 以几次读数的平均值作为初始基线(上电时不应触摸按键)
+  for (uint8_t i = 0; i < padCount; i++) {
+    uint32_t sum = 0;
+    for (uint8_t n = 0; n < TOUCH_CALIBRATE_SAMPLES; n++) {
+      sum += touchRead(pads[i].pin);
+    }
+    pads[i].baseline = (sum / TOUCH_CALIBRATE_SAMPLES) << 4;
+    pads[i].touched = false;
+    pads[i].isrTouched = 0;
+    updateThreshold(i);
+  }
+
+  esp_timer_create_args_t args = {};
+  args.callback = &TouchKeys::timerCallback;
+  args.arg = this;
+  args.name = "touchkeys";
+  if (esp_timer_create(&args, &timer) != ESP_OK) return false;
+  if (esp_timer_start_periodic(timer, TOUCH_SAMPLE_PERIOD_MS * 1000) != ESP_OK) {
+    esp_timer_delete(timer);
+    timer = NULL;
+    return false;
+  }
+#endif
+
+  running = true;
+  return true;
+}
+
+void TouchKeys::end() {
+  if (!running) return;
+#if defined(TOUCH_KEYS_HW)
+  esp_timer_stop(timer);
+  esp_timer_delete(timer);
+  timer = NULL;
+  for (uint8_t i = 0; i < padCount; i++) {
+    touchDetachInterrupt(pads[i].pin);
+    pads[i].attached = false;
+  }
+#endif
+  for (uint8_t i = 0; i < padCount; i++) {
+    bool isrTouched = __atomic_exchange_n(&pads[i].isrTouched, 0, __ATOMIC_ACQ_REL);
+    if (pads[i].touched || isrTouched) {
+      pads[i].touched = false;
+      keys->injectKeyLevel(firstKey + i, false);
+    }
+  }
+  running = false;
+}
+
+int32_t TouchKeys::deviation(const TouchPad &pad, uint32_t value) {
+#if defined(TOUCH_KEYS_RISING)
+  return (int32_t)value - (int32_t)(pad.baseline >> 4);
+#else
+  return (int32_t)(pad.baseline >> 4) - (int32_t)value;
+#endif
+}
+
+void TouchKeys::processReading(uint8_t index, uint32_t value) {
+  if (index >= padCount) return;
+  TouchPad &pad = pads[index];
+  if (pad.baseline == 0) pad.baseline = value << 4;  // 第一次读数作为基线
+
+  // 中断已置位的按下(电平已由中断注入)，取走标志后按回差判断是否仍然按着
+  bool isrTouched = __atomic_exchange_n(&pad.isrTouched, 0, __ATOMIC_ACQ_REL);
+  if (isrTouched) pad.touched = true;
+
+  // 按下/松开阈值不同，形成回差
+  int32_t threshold = (int32_t)((pad.baseline >> 4) * sensitivity / 100);
+  int32_t dev = deviation(pad, value);
+  bool touched = pad.touched ? dev > threshold / 2 : dev > threshold;
+
+  if (!touched) {
+    // 只在松开时跟踪基线，按住期间冻结，避免长按被当成漂移吸收
+    int32_t diff = (int32_t)(value << 4) - (int32_t)pad.baseline;
+    pad.baseline = (uint32_t)((int32_t)pad.baseline + diff / (1 << TOUCH_BASELINE_SHIFT));
+#if defined(TOUCH_KEYS_HW)
+    updateThreshold(index);
+#endif
+  }
+
+  // 中断注入过电平时总是重新注入，覆盖与上一次松开交错的注入顺序
+  if (touched != pad.touched || isrTouched) {
+    pad.touched = touched;
+    if (keys != NULL) keys->injectKeyLevel(firstKey + index, touched);
+  }
+}
+
+uint32_t TouchKeys::getBaseline(uint8_t index) {
+  return index < padCount ? pads[index].baseline >> 4 : 0;
+}
+
+void TouchKeys::poll(KeyLib &keys) {
+}
+
+unsigned long TouchKeys::pollInterval() {
+  return KEYLIB_NO_DEADLINE;
+}
+
+#if defined(TOUCH_KEYS_HW)
+void TouchKeys::timerCallback(void* arg) {
+  TouchKeys* self = (TouchKeys*)arg;
+  for (uint8_t i = 0; i < self->padCount; i++) {
+    self->processReading(i, touchRead(self->pads[i].pin));
+  }
+}
+
+void IRAM_ATTR TouchKeys::touchIsr(void* arg) {
+  // 超过阈值时立即注入按下，松开由定时器检测(ESP32的触摸中断只在超过阈值时产生)
+  // 按下状态由定时器回调维护，这里只置位标志交给它，不写touched
+  TouchPad* pad = (TouchPad*)arg;
+  if (__atomic_exchange_n(&pad->isrTouched, 1, __ATOMIC_ACQ_REL)) return;
+  pad->owner->keys->injectKeyLevel(pad->owner->firstKey + pad->index, true);
+}
+
+void TouchKeys::updateThreshold(uint8_t index) {
+  TouchPad &pad = pads[index];
+  uint32_t base = pad.baseline >> 4;
+  uint32_t delta = base * sensitivity / 100;
+#if defined(TOUCH_KEYS_RISING)
+  uint32_t threshold = delta;         // S2/S3：阈值是相对于硬件基准的增量
+#else
+  uint32_t threshold = base - delta;  // ESP32：读数低于阈值时产生中断
+#endif
+  if (!pad.attached) {
+    pad.threshold = threshold;
+    pad.attached = true;
+    touchAttachInterruptArg(pad.pin, touchIsr, &pad, threshold);
+    return;
+  }
+  // 基线变化不大时不重新设置；中断保持挂接，只写阈值寄存器
+  uint32_t change = threshold > pad.threshold ? threshold - pad.threshold : pad.threshold - threshold;
+  if (change * 64 < pad.threshold) return;
+  pad.threshold = threshold;
+  touch_pad_set_thresh((touch_pad_t)digitalPinToTouchChannel(pad.pin), threshold);
+}
+#endif
\ No newline at end of file
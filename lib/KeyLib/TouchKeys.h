@@ -0,0 +1,87 @@
+#ifndef TOUCHKEYS_H
+#define TOUCHKEYS_H
+
+#include <Arduino.h>
+#include "KeyLib.h"
+#if defined(ARDUINO_ARCH_ESP32)
+#include "esp_timer.h"
+#include "soc/soc_caps.h"
+#if defined(SOC_TOUCH_SENSOR_NUM) && SOC_TOUCH_SENSOR_NUM > 0
+#define TOUCH_KEYS_HW  // 有触摸外设
+#endif
+#endif
+
+#define TOUCH_MAX_PADS 10           // 最多的触摸按键数
+#define TOUCH_SAMPLE_PERIOD_MS 20   // 基线跟踪和松开检测的周期(毫秒)
+#define TOUCH_BASELINE_SHIFT 6      // 基线IIR滤波系数 1/2^6，约64个周期跟上漂移
+#define TOUCH_CALIBRATE_SAMPLES 8   // begin()时建立基线的采样数
+
+// 触摸按键：每个触摸通道对应一个虚拟按键，检测结果与GPIO按键一样消抖并产生手势事件
+// ESP32上由esp_timer定时读取触摸值并跟踪基线(IIR，按下期间冻结)，触摸外设的阈值中断在按下时立即置位，
+// 主循环不调用touchRead；没有触摸外设的平台可由外部调用processReading提供读数(主机测试)
+class TouchKeys : public KeyInputSource {
+  public:
+    // 第i个触摸按键对应虚拟按键firstKey+i
+    TouchKeys(uint8_t firstKey = KEYLIB_VIRTUAL_KEY_BASE);
+
+    // 添加触摸引脚，返回序号，失败返回-1(需在begin()之前调用)
+    int addPad(uint8_t pin);
+
+    // 灵敏度：读数偏离基线超过基线的percent%时为按下，回到一半以内为松开
+    void setSensitivity(uint8_t percent);
+
+    // 注册虚拟按键、建立基线并开始检测，成功返回true
+    bool begin(KeyLib &keys);
+
+    // 停止检测
+    void end();
+
+    // 处理一个触摸读数：更新基线并判断按下/松开(定时器回调调用；也可用于注入测试读数)
+    void processReading(uint8_t pad, uint32_t value);
+
+    // 当前基线
+    uint32_t getBaseline(uint8_t pad);
+
+    // 由KeyLib::update()调用；检测在定时器回调(或processReading)中完成，这里不读取触摸值
+    void poll(KeyLib &keys);
+
+    // 电平变化通过injectKeyLevel唤醒，不需要轮询
+    unsigned long pollInterval();
+
+  private:
+    struct TouchPad {
+      TouchKeys* owner;
+      uint8_t index;
+      uint8_t pin;
+      uint32_t baseline;            // 基线(Q4定点)，0为尚未建立
+      uint32_t threshold;           // 当前设置的中断阈值
+      bool attached;                // 已挂接阈值中断，之后只更新阈值
+      bool touched;                 // 当前的按下状态(只由定时器回调修改)
+      volatile uint8_t isrTouched;  // 中断检测到按下，由定时器回调原子地取走
+    };
+
+    TouchPad pads[TOUCH_MAX_PADS];
+    uint8_t padCount;
+    uint8_t firstKey;
+    uint8_t sensitivity;
+    KeyLib* keys;
+    bool running;
+
+#if defined(TOUCH_KEYS_HW)
+    esp_timer_handle_t timer;
+
+    // 定时读取所有触摸通道
+    static void timerCallback(void* arg);
+
+    // 触摸外设的阈值中断
+    static void IRAM_ATTR touchIsr(void* arg);
+
+    // 按基线更新触摸外设的中断阈值(第一次挂接中断，之后只写阈值寄存器)
+    void updateThreshold(uint8_t pad);
+#endif
+
+    // 读数偏离基线的量(按下方向为正)
+    int32_t deviation(const TouchPad &pad, uint32_t value);
+};
+
+#endif
\ No newline at end of file
@@ -3,18 +3,97 @@
  */
 
 #include "Buzzer.h"
+#include "ToneSynth.h"
+#if defined(ARDUINO_ARCH_ESP32)
+#include "driver/ledc.h"
+// LEDC和定时器使用arduino-esp32 2.x(IDF 4.4)的接口，3.x改为按引脚的新接口
+#if defined(ESP_ARDUINO_VERSION_MAJOR) && ESP_ARDUINO_VERSION_MAJOR >= 3
+#error "Buzzer requires arduino-esp32 2.x (ledcSetup/ledcAttachPin, timerBegin(num, divider, countUp))"
+#endif
+#endif
+
+// 默认提示音：导航音短而限速最严，报警音最长且优先级最高
+static const BuzzerFeedbackProfile defaultFeedbackProfiles[BUZZER_EVENT_COUNT] = {
+  // 频率, 时长, 音量, 优先级, 最短间隔, 合并窗口
+  { 1000,  20, -1, 0,  40,  25 }, // BUZZER_EVENT_NAVIGATE
+  { 1000,  20, -1, 1,  60,  30 }, // BUZZER_EVENT_SELECT
+  { 1000, 100, -1, 1, 120,  60 }, // BUZZER_EVENT_BACK
+  {  400, 150, -1, 2, 200, 150 }, // BUZZER_EVENT_ERROR
+  { 2500, 300, -1, 3, 300,   0 }, // BUZZER_EVENT_ALARM
+};
 
 Buzzer::Buzzer(uint8_t pin, int8_t volumePin) {
   _pin = pin;
   _volumePin = volumePin;
   _volumeLevel = 10; // 默认最大音量
   _isActive = false;
+  _async = false;
+  _toneStart = 0;
+  _toneDuration = 0;
+#if defined(ARDUINO_ARCH_ESP32)
+  _ledcChannel = BUZZER_LEDC_CHANNEL;
+#else
+  _ledcChannel = -1; // 其他平台默认不使用LEDC；主机测试可用setLedcChannel()启用记录频率/占空比的替身
+#endif
+  _ledcReady = false;
+  _ledcFrequency = 0;
+  _ledcDuty = 0;
+  _synth = NULL;
+  _softPwmHighUs = 0;
+  _softPwmLowUs = 0;
+  _softPwmLevel = false;
+  _softPwmRunning = false;
+  _softPwmFrequency = 0;
+  _softPwmVolume = 0;
+#if defined(ARDUINO_ARCH_ESP32)
+  _softPwmTimer = NULL;
+#else
+  _softPwmNextEdge = 0;
+#endif
+  _melodyHead = 0;
+  _melodyCount = 0;
+  _notePhase = 0;
+  _notePhaseStart = 0;
+  _tuneSource = 0;
+  _tuneNotes = NULL;
+  _tuneMelody = NULL;
+  _tuneDurations = NULL;
+  _tuneLength = 0;
+  _tuneIndex = 0;
+  _tunePriority = 0;
+  _tuneVolume = 0;
+  _tuneCallback = NULL;
+  _effect = 0;
+  _effectHardware = false;
+  _effectStartUs = 0;
+  _effectDurationUs = 0;
+  _effectFrom = 0;
+  _effectTo = 0;
+  _effectSteps = 1;
+  _effectStep = 0;
+  _effectFrequency = 0;
+  _effectVolume = 0;
+  for (uint8_t i = 0; i < BUZZER_EVENT_COUNT; i++) {
+    _feedbackProfiles[i] = defaultFeedbackProfiles[i];
+    _feedbackLast[i] = 0;
+  }
+  _feedbackPending = 0;
+  _feedbackPlayed = 0;
+  _feedbackSounding = -1;
+#if defined(ARDUINO_ARCH_ESP32)
+  _sweepTimer = NULL;
+  _ledcFadeReady = false;
+#endif
 }
 
 void Buzzer::begin() {
   pinMode(_pin, OUTPUT);
-  if (_volumePin >= 0) {
+  if (_synth != NULL) {
+    _synth->begin(); // 合成器占用DAC引脚，不再配置音量引脚
+  } else if (_volumePin >= 0) {
     pinMode(_volumePin, OUTPUT);
+  } else if (_ledcChannel >= 0) {
+    _setupLedc();
   }
   stop();
 }
@@ -37,80 +116,728 @@ void Buzzer::_applyVolume(uint8_t volume) {
   }
 }
 
-void Buzzer::beep(unsigned int duration, unsigned int frequency, int8_t volume) {
-  uint8_t volumeToUse = (volume >= 0) ? volume : _volumeLevel;
-  
-  if (volumeToUse == 0) {
-    delay(duration); // 音量为0时不发声，但保持时间延迟
+void Buzzer::setLedcChannel(int8_t channel) {
+  _ledcChannel = channel;
+  _ledcReady = false;
+}
+
+unsigned int Buzzer::getLedcFrequency() {
+  return _ledcFrequency;
+}
+
+uint32_t Buzzer::getLedcDuty() {
+  return _ledcDuty;
+}
+
+void Buzzer::_setupLedc() {
+#if defined(ARDUINO_ARCH_ESP32)
+  ledcSetup(_ledcChannel, 2000, BUZZER_LEDC_RESOLUTION);
+  ledcAttachPin(_pin, _ledcChannel);
+  ledcWrite(_ledcChannel, 0);
+#endif
+  _ledcFrequency = 0;
+  _ledcDuty = 0;
+  _ledcReady = true;
+}
+
+void Buzzer::setSynth(ToneSynth* synth) {
+  _synth = synth;
+}
+
+bool Buzzer::_usesLedc() {
+  return _synth == NULL && _volumePin < 0 && _ledcChannel >= 0;
+}
+
+void Buzzer::_startTone(unsigned int frequency, uint8_t volume) {
+  if (_synth != NULL) {
+    _synth->noteOn(frequency, volume);
+  } else if (_volumePin >= 0) {
+    _applyVolume(volume);
+    tone(_pin, frequency);
+  } else if (_ledcChannel >= 0) {
+    if (!_ledcReady) {
+      _setupLedc();
+    }
+    _ledcFrequency = frequency;
+    _ledcDuty = _ledcDutyFor(volume);
+#if defined(ARDUINO_ARCH_ESP32)
+    ledcChangeFrequency(_ledcChannel, frequency, BUZZER_LEDC_RESOLUTION);
+    ledcWrite(_ledcChannel, _ledcDuty);
+#endif
+  } else {
+    _softPwmSet(frequency, volume); // 既没有音量引脚也不使用LEDC时，由定时器中断产生PWM
+  }
+}
+
+uint32_t Buzzer::_ledcDutyFor(uint8_t volume) {
+  // 方波在50%占空比时最响，因此将音量(0-50)映射到0-50%的占空比
+  return (uint32_t)volume * (1UL << (BUZZER_LEDC_RESOLUTION - 1)) / 50;
+}
+
+void Buzzer::_setToneFrequency(unsigned int frequency) {
+  if (_synth != NULL) {
+    _synth->setFrequency(frequency);
+  } else if (_usesLedc()) {
+    _ledcFrequency = frequency;
+#if defined(ARDUINO_ARCH_ESP32)
+    ledcChangeFrequency(_ledcChannel, frequency, BUZZER_LEDC_RESOLUTION); // 占空比寄存器不受影响
+#endif
+  } else if (_volumePin >= 0) {
+    tone(_pin, frequency);
+  } else {
+    _softPwmSet(frequency, _softPwmVolume);
+  }
+}
+
+void Buzzer::_setToneVolume(uint8_t volume) {
+  if (_synth != NULL) {
+    _synth->setVolume(volume);
+  } else if (_volumePin >= 0) {
+    _applyVolume(volume);
+  } else if (_ledcChannel >= 0) {
+    _ledcDuty = _ledcDutyFor(volume);
+#if defined(ARDUINO_ARCH_ESP32)
+    ledcWrite(_ledcChannel, _ledcDuty);
+#endif
+  } else {
+    _softPwmSet(_softPwmFrequency, volume);
+  }
+}
+
+void Buzzer::_stopTone() {
+  if (_synth != NULL) {
+    _synth->noteOff(); // 按释音时间淡出，没有咔嗒声
+    return;
+  }
+  if (_usesLedc()) {
+    // LEDC通道保持连接，只把占空比清零
+    _ledcFrequency = 0;
+    _ledcDuty = 0;
+#if defined(ARDUINO_ARCH_ESP32)
+    if (_ledcReady) {
+      ledcWrite(_ledcChannel, 0);
+    }
+#endif
     return;
   }
-  
   if (_volumePin >= 0) {
-    _applyVolume(volumeToUse);
-    tone(_pin, frequency);
-    delay(duration);
     noTone(_pin);
-  } else {
-    // 没有专用音量控制引脚时，使用软件PWM模拟音量
-    _toneWithVolume(_pin, frequency, duration, volumeToUse);
+    analogWrite(_volumePin, 0);
+    return;
+  }
+  _softPwmStop();
+}
+
+#if defined(ARDUINO_ARCH_ESP32)
+Buzzer* volatile Buzzer::_softPwmOwner = NULL;
+
+void IRAM_ATTR Buzzer::_softPwmIsr() {
+  Buzzer* buzzer = _softPwmOwner;
+  if (buzzer == NULL) return;
+  // 自动重装模式：翻转引脚后把下一段电平的时长写入报警值
+  bool level = !buzzer->_softPwmLevel;
+  buzzer->_softPwmLevel = level;
+  digitalWrite(buzzer->_pin, level ? HIGH : LOW);
+  timerAlarmWrite(buzzer->_softPwmTimer, level ? buzzer->_softPwmHighUs : buzzer->_softPwmLowUs, true);
+}
+#endif
+
+void Buzzer::_softPwmSet(unsigned int frequency, uint8_t volume) {
+  _softPwmFrequency = frequency;
+  _softPwmVolume = volume;
+  if (frequency == 0 || volume == 0) {
+    _softPwmStop();
+    return;
+  }
+  
+  // 音量(0-50)映射到0-50%的占空比，与LEDC后端一致
+  uint32_t period = 1000000UL / frequency;
+  uint32_t high = period * volume / 100;
+  if (high < BUZZER_SOFT_PWM_MIN_US) high = BUZZER_SOFT_PWM_MIN_US;
+  uint32_t low = period > high + BUZZER_SOFT_PWM_MIN_US ? period - high : BUZZER_SOFT_PWM_MIN_US;
+  _softPwmHighUs = high;
+  _softPwmLowUs = low;
+  if (_softPwmRunning) return; // 正在运行时只改时长，在下一个边沿生效，波形连续
+  
+  _softPwmRunning = true;
+  _softPwmLevel = true;
+  digitalWrite(_pin, HIGH);
+#if defined(ARDUINO_ARCH_ESP32)
+  if (_softPwmTimer == NULL) {
+    _softPwmTimer = timerBegin(BUZZER_SOFT_PWM_TIMER, 80, true); // 80MHz APB / 80 = 1us计数
+    timerAttachInterrupt(_softPwmTimer, &Buzzer::_softPwmIsr, false); // ESP32定时器只支持电平中断
+  }
+  _softPwmOwner = this;
+  timerWrite(_softPwmTimer, 0);
+  timerAlarmWrite(_softPwmTimer, high, true);
+  timerAlarmEnable(_softPwmTimer);
+#else
+  _softPwmNextEdge = micros() + high;
+#endif
+}
+
+void Buzzer::_softPwmStop() {
+  if (!_softPwmRunning) return;
+#if defined(ARDUINO_ARCH_ESP32)
+  timerAlarmDisable(_softPwmTimer);
+#endif
+  _softPwmRunning = false;
+  _softPwmLevel = false;
+  digitalWrite(_pin, LOW);
+}
+
+#if !defined(ARDUINO_ARCH_ESP32)
+void Buzzer::_softPwmPoll() {
+  // 没有定时器中断的平台由service()补上到期的边沿，精度取决于调用频率
+  if (!_softPwmRunning) return;
+  unsigned long now = micros();
+  uint8_t edges = 0;
+  while ((long)(now - _softPwmNextEdge) >= 0 && edges < 2) {
+    _softPwmLevel = !_softPwmLevel;
+    _softPwmNextEdge += _softPwmLevel ? _softPwmHighUs : _softPwmLowUs;
+    edges++;
   }
+  if ((long)(now - _softPwmNextEdge) >= 0) {
+    _softPwmNextEdge = now; // 落后太多时不追赶
+  }
+  if (edges > 0) {
+    digitalWrite(_pin, _softPwmLevel ? HIGH : LOW);
+  }
+}
+#endif
+
+void Buzzer::beep(unsigned int duration, unsigned int frequency, int8_t volume) {
+  uint8_t volumeToUse = (volume >= 0) ? volume : _volumeLevel;
+  _timedTone(duration, frequency, volumeToUse);
 }
 
 void Buzzer::longBeep(unsigned int duration, unsigned int frequency, int8_t volume) {
   uint8_t volumeToUse = (volume >= 0) ? volume : _volumeLevel;
+  _timedTone(duration, frequency, volumeToUse);
+}
+
+void Buzzer::_timedTone(unsigned int duration, unsigned int frequency, uint8_t volume) {
+  if (!_async) {
+    if (volume == 0) {
+      delay(duration); // 音量为0时不发声，但保持时间延迟
+      return;
+    }
+    
+    _startTone(frequency, volume);
+    _wait(duration);
+    _stopTone();
+    return;
+  }
   
-  if (volumeToUse == 0) {
-    delay(duration);
+  // 异步模式：新的发声直接替换正在进行的发声，不等待
+  _stopEffect();
+  _feedbackSounding = -1; // 由_playFeedback在之后重新标记
+  if (volume == 0) {
+    if (_isActive) _endBeep(); // 静音时不发声，也不占用时间
     return;
   }
   
-  if (_volumePin >= 0) {
-    _applyVolume(volumeToUse);
-    tone(_pin, frequency);
-    delay(duration);
-    noTone(_pin);
+  _startTone(frequency, volume);
+  _toneStart = millis();
+  _toneDuration = duration;
+  _isActive = true;
+}
+
+void Buzzer::_wait(unsigned long ms) {
+#if defined(ARDUINO_ARCH_ESP32)
+  delay(ms); // 软件PWM由定时器中断驱动、合成器由自己的任务填充，delay期间照常发声
+#else
+  // 阻塞等待期间也要持续补写合成器的采样、推进软件PWM
+  unsigned long start = millis();
+  while (millis() - start < ms) {
+    if (_synth != NULL) _synth->pump();
+    _softPwmPoll();
+    delay(1);
+  }
+#endif
+}
+
+void Buzzer::setAsync(bool enable) {
+  if (!enable && _isActive) {
+    stop(); // 切换回阻塞模式时结束未完成的异步发声
+  }
+  _async = enable;
+}
+
+void Buzzer::service() {
+  if (_synth != NULL) {
+    _synth->pump(); // 主机上补写WAV采样(ESP32上DMA由合成器的任务填充)
+  }
+#if !defined(ARDUINO_ARCH_ESP32)
+  _softPwmPoll();
+#endif
+  if (_isActive) {
+    if (millis() - _toneStart >= _toneDuration) {
+      _endBeep();
+    } else if (_effect != 0 && !_effectHardware) {
+      _serviceEffect();
+    }
+  }
+  _serviceFeedback();
+  _serviceMelody();
+  _refillTune();
+}
+
+void Buzzer::_endBeep() {
+  _stopEffect();
+  _isActive = false;
+  _feedbackSounding = -1;
+  // 短响结束后，若旋律音符仍在发声则恢复该音符，否则停止
+  if (_notePhase == 1 && _melodyCount > 0 && _melodyQueue[_melodyHead].frequency > 0 && _melodyQueue[_melodyHead].volume > 0) {
+    _startTone(_melodyQueue[_melodyHead].frequency, _melodyQueue[_melodyHead].volume);
   } else {
-    _toneWithVolume(_pin, frequency, duration, volumeToUse);
+    _stopTone();
   }
 }
 
-void Buzzer::sweepTone(unsigned int duration, unsigned int startFreq, unsigned int endFreq, unsigned int steps, int8_t volume) {
-  uint8_t volumeToUse = (volume >= 0) ? volume : _volumeLevel;
+void Buzzer::feedback(BuzzerEvent event) {
+  if (event >= BUZZER_EVENT_COUNT) return;
+  const BuzzerFeedbackProfile &profile = _feedbackProfiles[event];
+  unsigned long now = millis();
+  uint8_t bit = 1 << event;
   
-  if (volumeToUse == 0) {
-    delay(duration);
+  if ((_feedbackPlayed & bit) == 0 || now - _feedbackLast[event] >= profile.minInterval) {
+    if (_playFeedback(event, now)) {
+      _feedbackPending &= ~bit;
+    }
     return;
   }
+  if (now - _feedbackLast[event] < profile.coalesceWindow) {
+    return; // 并入上次发声
+  }
+  _feedbackPending |= bit; // 限速期内的后续事件合并为一次延后发声
+}
+
+void Buzzer::setFeedbackProfile(BuzzerEvent event, const BuzzerFeedbackProfile &profile) {
+  if (event >= BUZZER_EVENT_COUNT) return;
+  _feedbackProfiles[event] = profile;
+}
+
+BuzzerFeedbackProfile Buzzer::getFeedbackProfile(BuzzerEvent event) {
+  if (event >= BUZZER_EVENT_COUNT) event = BUZZER_EVENT_NAVIGATE;
+  return _feedbackProfiles[event];
+}
+
+bool Buzzer::_playFeedback(uint8_t event, unsigned long now) {
+  const BuzzerFeedbackProfile &profile = _feedbackProfiles[event];
+  // 低于正在发声的提示音优先级时丢弃，同级或更高则抢占
+  if (_isActive && _feedbackSounding >= 0 && _feedbackSounding != event &&
+      _feedbackProfiles[_feedbackSounding].priority > profile.priority) {
+    return false;
+  }
+  _feedbackLast[event] = now;
+  _feedbackPlayed |= 1 << event;
+  uint8_t volumeToUse = (profile.volume >= 0) ? profile.volume : _volumeLevel;
+  _timedTone(profile.duration, profile.frequency, volumeToUse);
+  _feedbackSounding = (_async && _isActive) ? event : -1;
+  return true;
+}
+
+void Buzzer::_serviceFeedback() {
+  if (_feedbackPending == 0) return;
+  unsigned long now = millis();
+  // 从高到低检查，优先播放高优先级事件(默认配置中事件编号越大优先级越高)
+  for (int8_t event = BUZZER_EVENT_COUNT - 1; event >= 0; event--) {
+    uint8_t bit = 1 << event;
+    if ((_feedbackPending & bit) == 0) continue;
+    if (now - _feedbackLast[event] < _feedbackProfiles[event].minInterval) continue;
+    // 被挡住的延后提示音不再保留，避免高优先级提示音结束后补发过时的声音
+    _feedbackPending &= ~bit;
+    _playFeedback(event, now);
+  }
+}
+
+bool Buzzer::isBusy() {
+  return _isActive || _melodyCount > 0 || _tuneSource != 0 || _feedbackPending != 0;
+}
+
+bool Buzzer::queueMelody(const unsigned int melody[], const unsigned int durations[], unsigned int length,
+                         uint8_t priority, BuzzerMelodyCallback onComplete, int8_t volume) {
+  if (length == 0) return false;
+  uint8_t volumeToUse = (volume >= 0) ? volume : _volumeLevel;
   
-  unsigned int stepDuration = duration / steps;
-  float freqStep = (float)(endFreq - startFreq) / steps;
+  // Flash旋律还在读入时，音符只能排在它后面，因此只接受更高优先级的抢占
+  if (_tuneSource != 0 && priority <= _tunePriority) return false;
   
-  for (unsigned int i = 0; i < steps; i++) {
-    unsigned int currentFreq = startFreq + (i * freqStep);
+  // 抢占会清除的低优先级音符(队列按优先级不增顺序排列，都在队尾)，先算出空间再动队列
+  unsigned int freed = 0;
+  while (freed < _melodyCount &&
+         _melodyQueue[(_melodyHead + _melodyCount - 1 - freed) % BUZZER_MELODY_QUEUE_SIZE].priority < priority) {
+    freed++;
+  }
+  unsigned int space = BUZZER_MELODY_QUEUE_SIZE - _melodyCount + freed;
+  unsigned int count = length < space ? length : space;
+  
+  _cancelTune();
+  _preemptBelow(priority);
+  
+  // 只复制放得下的部分，数组在返回后可能失效(如调用者栈上的数组)，不能留到之后再读
+  for (unsigned int i = 0; i < count; i++) {
+    QueuedNote &note = _melodyQueue[(_melodyHead + _melodyCount) % BUZZER_MELODY_QUEUE_SIZE];
+    note.frequency = melody[i];
+    note.duration = durations[i];
+    note.priority = priority;
+    note.volume = volumeToUse;
+    note.onComplete = (i == count - 1) ? onComplete : NULL;
+    _melodyCount++;
+  }
+  
+  if (_notePhase == 0 && _melodyCount > 0) {
+    _startQueuedNote();
+  }
+  return count == length;
+}
+
+void Buzzer::_preemptBelow(uint8_t priority) {
+  // 队列按优先级不增顺序排列，低优先级都在队尾
+  while (_melodyCount > 0) {
+    uint8_t tail = (_melodyHead + _melodyCount - 1) % BUZZER_MELODY_QUEUE_SIZE;
+    if (_melodyQueue[tail].priority >= priority) break;
+    if (_melodyCount == 1) {
+      _popQueuedNote(false); // 正在播放的音符被抢占
+      _notePhase = 0;
+      if (!_isActive) _stopTone();
+    } else {
+      _melodyCount--;
+      if (_melodyQueue[tail].onComplete != NULL) _melodyQueue[tail].onComplete(false);
+    }
+  }
+}
+
+void Buzzer::cancelMelody() {
+  _cancelTune();
+  bool wasPlaying = _notePhase == 1;
+  while (_melodyCount > 0) {
+    _popQueuedNote(false);
+  }
+  _notePhase = 0;
+  if (wasPlaying && !_isActive) {
+    _stopTone();
+  }
+}
+
+bool Buzzer::isMelodyPlaying() {
+  return _melodyCount > 0 || _tuneSource != 0;
+}
+
+bool Buzzer::playTune(const BuzzerNote* tune, uint16_t length, uint8_t priority,
+                      BuzzerMelodyCallback onComplete, int8_t volume) {
+  if (tune == NULL || length == 0) return false;
+  if (_tuneSource != 0 && priority <= _tunePriority) return false;
+  _cancelTune();
+  _tuneSource = 1;
+  _tuneNotes = tune;
+  _tuneLength = length;
+  _tuneIndex = 0;
+  _tunePriority = priority;
+  _tuneVolume = (volume >= 0) ? volume : _volumeLevel;
+  _tuneCallback = onComplete;
+  return _startTune();
+}
+
+bool Buzzer::streamMelody(const unsigned int melody[], const unsigned int durations[], uint16_t length,
+                          uint8_t priority, BuzzerMelodyCallback onComplete, int8_t volume) {
+  if (melody == NULL || durations == NULL || length == 0) return false;
+  if (_tuneSource != 0 && priority <= _tunePriority) return false;
+  _cancelTune();
+  _tuneSource = 3;
+  _tuneMelody = melody;
+  _tuneDurations = durations;
+  _tuneLength = length;
+  _tuneIndex = 0;
+  _tunePriority = priority;
+  _tuneVolume = (volume >= 0) ? volume : _volumeLevel;
+  _tuneCallback = onComplete;
+  return _startTune();
+}
+
+bool Buzzer::playRtttl(const char* rtttl, uint8_t priority, BuzzerMelodyCallback onComplete, int8_t volume) {
+  if (_tuneSource != 0 && priority <= _tunePriority) return false;
+  BuzzerRtttlReader reader;
+  if (!reader.begin(rtttl)) return false; // 先验证头部，失败时不打断正在播放的旋律
+  _cancelTune();
+  _tuneSource = 2;
+  _rtttl = reader;
+  _tunePriority = priority;
+  _tuneVolume = (volume >= 0) ? volume : _volumeLevel;
+  _tuneCallback = onComplete;
+  return _startTune();
+}
+
+bool Buzzer::_startTune() {
+  _preemptBelow(_tunePriority);
+  
+  _refillTune();
+  
+  if (!_async) {
+    // 阻塞模式：边播放边读入，直到播放完毕
+    while (isMelodyPlaying()) {
+      service();
+      delay(1);
+    }
+  }
+  return true;
+}
+
+void Buzzer::_refillTune() {
+  while (_tuneSource != 0 && _melodyCount < BUZZER_TUNE_PREFETCH) {
+    BuzzerNote note;
+    bool more;
+    if (_tuneSource == 1) {
+      note.frequency = pgm_read_word(&_tuneNotes[_tuneIndex].frequency);
+      note.duration = pgm_read_word(&_tuneNotes[_tuneIndex].duration);
+      _tuneIndex++;
+      more = _tuneIndex < _tuneLength;
+    } else if (_tuneSource == 3) {
+      note.frequency = _tuneMelody[_tuneIndex];
+      note.duration = _tuneDurations[_tuneIndex];
+      _tuneIndex++;
+      more = _tuneIndex < _tuneLength;
+    } else {
+      if (!_rtttl.next(note)) {
+        _cancelTune(); // 格式错误，已读入的音符照常播放完
+        return;
+      }
+      more = !_rtttl.done();
+    }
     
-    if (_volumePin >= 0) {
-      _applyVolume(volumeToUse);
-      tone(_pin, currentFreq);
-      delay(stepDuration);
+    QueuedNote &queued = _melodyQueue[(_melodyHead + _melodyCount) % BUZZER_MELODY_QUEUE_SIZE];
+    queued.frequency = note.frequency;
+    // 音符间停顿从时值中扣除，保持旋律的节拍(streamMelody与queueMelody一样使用原时值)
+    if (_tuneSource == 3) {
+      queued.duration = note.duration;
     } else {
-      _toneWithVolume(_pin, currentFreq, stepDuration, volumeToUse);
+      queued.duration = note.duration > 2 * BUZZER_NOTE_GAP ? note.duration - BUZZER_NOTE_GAP : note.duration;
+    }
+    queued.priority = _tunePriority;
+    queued.volume = _tuneVolume;
+    queued.onComplete = more ? NULL : _tuneCallback;
+    _melodyCount++;
+    if (!more) {
+      _tuneSource = 0; // 最后一个音符已带上回调
+    }
+    
+    if (_notePhase == 0) {
+      _startQueuedNote();
     }
   }
+}
+
+void Buzzer::_cancelTune() {
+  if (_tuneSource == 0) return;
+  _tuneSource = 0;
+  if (_tuneCallback != NULL) {
+    _tuneCallback(false);
+  }
+}
+
+void Buzzer::_serviceMelody() {
+  if (_notePhase == 0 || _melodyCount == 0) return;
   
-  if (_volumePin >= 0) {
-    noTone(_pin);
+  unsigned long now = millis();
+  if (_notePhase == 1) {
+    if (now - _notePhaseStart < _melodyQueue[_melodyHead].duration) return;
+    if (!_isActive) _stopTone(); // 短响正在发声时不打断它
+    _notePhase = 2;
+    _notePhaseStart += _melodyQueue[_melodyHead].duration; // 按计划时间推进，避免累积误差
+  }
+  
+  if (_notePhase == 2 && now - _notePhaseStart >= BUZZER_NOTE_GAP) {
+    _popQueuedNote(true);
+    _notePhase = 0;
+    if (_melodyCount > 0) {
+      _startQueuedNote();
+    }
   }
 }
 
-void Buzzer::stop() {
-  noTone(_pin);
-  if (_volumePin >= 0) {
-    analogWrite(_volumePin, 0);
+void Buzzer::_startQueuedNote() {
+  QueuedNote &note = _melodyQueue[_melodyHead];
+  _notePhase = 1;
+  _notePhaseStart = millis();
+  // 短响正在发声时由它占用输出，短响结束后在service()中恢复本音符
+  if (!_isActive) {
+    if (note.frequency > 0 && note.volume > 0) {
+      _startTone(note.frequency, note.volume);
+    } else {
+      _stopTone(); // 休止符或静音
+    }
+  }
+}
+
+void Buzzer::_popQueuedNote(bool completed) {
+  BuzzerMelodyCallback onComplete = _melodyQueue[_melodyHead].onComplete;
+  _melodyHead = (_melodyHead + 1) % BUZZER_MELODY_QUEUE_SIZE;
+  _melodyCount--;
+  if (onComplete != NULL) {
+    onComplete(completed);
   }
+}
+
+void Buzzer::sweepTone(unsigned int duration, unsigned int startFreq, unsigned int endFreq, unsigned int steps, int8_t volume) {
+  uint8_t volumeToUse = (volume >= 0) ? volume : _volumeLevel;
+  if (steps == 0) steps = 1;
+  
+  if (!_async) {
+    if (volumeToUse == 0) {
+      delay(duration);
+      return;
+    }
+  } else if (volumeToUse == 0) {
+    _stopEffect();
+    if (_isActive) _endBeep();
+    return;
+  }
+  
+  _stopEffect();
+  _effectFrom = startFreq;
+  _effectTo = endFreq;
+  _effectSteps = steps;
+  _effectStep = 0;
+  _effectVolume = volumeToUse;
+  _startTone(startFreq, volumeToUse);
+  _startEffect(1, duration);
+}
+
+void Buzzer::_sweepTo(unsigned long elapsedUs) {
+  if (_effectDurationUs == 0) return;
+  // 第i步的频率为 起始 + (结束-起始) * i / steps，每步占 duration/steps
+  unsigned int step = (unsigned long long)elapsedUs * _effectSteps / _effectDurationUs;
+  if (step >= _effectSteps) step = _effectSteps - 1;
+  if (step == _effectStep) return;
+  _effectStep = step;
+  long span = (long)_effectTo - (long)_effectFrom;
+  _setToneFrequency((unsigned int)((long)_effectFrom + span * (long)step / (long)_effectSteps));
+}
+
+#if defined(ARDUINO_ARCH_ESP32)
+void Buzzer::_sweepTimerCallback(void* arg) {
+  Buzzer* buzzer = (Buzzer*)arg;
+  if (buzzer->_effect != 1) return;
+  buzzer->_sweepTo((unsigned long)esp_timer_get_time() - buzzer->_effectStartUs);
+}
+#endif
+
+void Buzzer::_startEffect(uint8_t effect, unsigned int duration) {
+  _effect = effect;
+  _effectHardware = false;
+  _effectDurationUs = (unsigned long)duration * 1000UL;
+#if defined(ARDUINO_ARCH_ESP32)
+  _effectStartUs = (unsigned long)esp_timer_get_time();
+#else
+  _effectStartUs = micros();
+#endif
+  _toneStart = millis();
+  _toneDuration = duration;
+  _isActive = true;
+  
+  if (effect == 1) {
+#if defined(ARDUINO_ARCH_ESP32)
+    // 由定时器在每个步进边界更新LEDC频率，主循环不参与
+    if (_usesLedc() && _effectSteps > 1) {
+      if (_sweepTimer == NULL) {
+        esp_timer_create_args_t args = {};
+        args.callback = &Buzzer::_sweepTimerCallback;
+        args.arg = this;
+        args.name = "buzzer_sweep";
+        esp_timer_create(&args, &_sweepTimer);
+      }
+      unsigned long periodUs = _effectDurationUs / _effectSteps;
+      if (periodUs < BUZZER_SWEEP_MIN_STEP_US) periodUs = BUZZER_SWEEP_MIN_STEP_US;
+      if (_sweepTimer != NULL && esp_timer_start_periodic(_sweepTimer, periodUs) == ESP_OK) {
+        _effectHardware = true;
+      }
+    }
+#endif
+  } else {
+    _effectHardware = _startHardwareFade();
+  }
+  
+  if (!_async) {
+    // 阻塞模式：等待效果结束(软件步进的效果在这里推进)
+    while (_isActive) {
+      service();
+      delay(1);
+    }
+  }
+}
+
+bool Buzzer::_startHardwareFade() {
+#if defined(ARDUINO_ARCH_ESP32)
+  if (!_usesLedc() || _effectDurationUs == 0) return false;
+  if (!_ledcFadeReady) {
+    esp_err_t err = ledc_fade_func_install(0);
+    _ledcFadeReady = (err == ESP_OK || err == ESP_ERR_INVALID_STATE); // 已被其他代码安装也可用
+    if (!_ledcFadeReady) return false;
+  }
+  // Arduino的通道号：0-7为第一组(ESP32上为高速模式)，8-15为第二组
+  ledc_mode_t mode = (ledc_mode_t)(_ledcChannel / 8);
+  ledc_channel_t channel = (ledc_channel_t)(_ledcChannel % 8);
+  _ledcDuty = _ledcDutyFor(_effectTo);
+  if (ledc_set_fade_with_time(mode, channel, _ledcDuty, _effectDurationUs / 1000) != ESP_OK) return false;
+  return ledc_fade_start(mode, channel, LEDC_FADE_NO_WAIT) == ESP_OK;
+#else
+  return false;
+#endif
+}
+
+void Buzzer::_serviceEffect() {
+#if defined(ARDUINO_ARCH_ESP32)
+  unsigned long elapsedUs = (unsigned long)esp_timer_get_time() - _effectStartUs;
+#else
+  unsigned long elapsedUs = micros() - _effectStartUs;
+#endif
+  if (_effect == 1) {
+    _sweepTo(elapsedUs);
+  } else if (_effect == 2 && _effectDurationUs > 0) {
+    // 软件渐变：按时间线性插值，每BUZZER_FADE_STEP_MS量化一次，音量变化时才写出
+    unsigned long stepUs = BUZZER_FADE_STEP_MS * 1000UL;
+    unsigned long quantized = elapsedUs - elapsedUs % stepUs;
+    if (quantized > _effectDurationUs) quantized = _effectDurationUs;
+    long span = (long)_effectTo - (long)_effectFrom;
+    unsigned int volume = (unsigned int)((long)_effectFrom + span * (long long)quantized / (long long)_effectDurationUs);
+    if (volume != _effectStep) {
+      _effectStep = volume;
+      _setToneVolume(volume);
+    }
+  }
+}
+
+void Buzzer::_stopEffect() {
+  if (_effect == 0) return;
+#if defined(ARDUINO_ARCH_ESP32)
+  uint8_t effect = _effect;
+  _effect = 0; // 先清除，定时器回调看到后不再改频率
+  if (_effectHardware && effect == 1) {
+    esp_timer_stop(_sweepTimer);
+  }
+  // 硬件音量渐变不需要停止：IDF 4.4没有ledc_fade_stop，随后的ledcWrite会覆盖渐变配置
+#else
+  _effect = 0;
+#endif
+  _effectHardware = false;
+}
+
+void Buzzer::stop() {
+  _stopEffect();
+  _feedbackPending = 0;
+  _feedbackSounding = -1;
+  cancelMelody();
+  _stopTone();
   _isActive = false;
 }
 
 void Buzzer::playMelody(unsigned int melody[], unsigned int durations[], unsigned int length, int8_t volume) {
+  if (_async) {
+    queueMelody(melody, durations, length, 0, NULL, volume); // 异步模式下不阻塞
+    return;
+  }
+  
   uint8_t volumeToUse = (volume >= 0) ? volume : _volumeLevel;
   
   if (volumeToUse == 0) {
@@ -124,15 +851,10 @@ void Buzzer::playMelody(unsigned int melody[], unsigned int durations[], unsigne
   }
   
   for (unsigned int i = 0; i < length; i++) {
-    if (_volumePin >= 0) {
-      _applyVolume(volumeToUse);
-      tone(_pin, melody[i]);
-      delay(durations[i]);
-      noTone(_pin);
-    } else {
-      _toneWithVolume(_pin, melody[i], durations[i], volumeToUse);
-    }
-    delay(50); // 音符之间的短暂停顿
+    _startTone(melody[i], volumeToUse);
+    _wait(durations[i]);
+    _stopTone();
+    _wait(50); // 音符之间的短暂停顿
   }
 }
 
@@ -140,48 +862,11 @@ void Buzzer::fadeVolume(unsigned int duration, uint8_t startVolume, uint8_t endV
   startVolume = constrain(startVolume, 0, 50);
   endVolume = constrain(endVolume, 0, 50);
   
-  unsigned int steps = 5; // 音量变化的步数
-  unsigned int stepDuration = duration / steps;
-  float volumeStep = (float)(endVolume - startVolume) / steps;
-  
-  for (unsigned int i = 0; i < steps; i++) {
-    uint8_t currentVolume = startVolume + (i * volumeStep);
-    
-    if (_volumePin >= 0) {
-      _applyVolume(currentVolume);
-      tone(_pin, frequency);
-      delay(stepDuration);
-    } else {
-      _toneWithVolume(_pin, frequency, stepDuration, currentVolume);
-    }
-  }
-  
-  if (_volumePin >= 0) {
-    noTone(_pin);
-  }
+  _stopEffect();
+  _effectFrom = startVolume;
+  _effectTo = endVolume;
+  _effectStep = startVolume;
+  _effectFrequency = frequency;
+  _startTone(frequency, startVolume);
+  _startEffect(2, duration);
 }
-
-void Buzzer::_toneWithVolume(uint8_t pin, unsigned int frequency, unsigned long duration, uint8_t volume) {
-  // 将音量(0-10)转换为占空比(0-100%)
-  int dutyCycle = map(volume, 0, 50, 0, 100);
-  
-  // 计算一个周期的微秒数
-  unsigned long periodMicros = 1000000 / frequency;
-  
-  // 计算高电平持续的微秒数
-  unsigned long highMicros = periodMicros * dutyCycle / 100;
-  
-  // 计算低电平持续的微秒数
-  unsigned long lowMicros = periodMicros - highMicros;
-  
-  // 计算需要多少个周期
-  unsigned long cycles = (duration * 1000) / periodMicros;
-  
-  // 生成指定频率和音量的方波
-  for (unsigned long i = 0; i < cycles; i++) {
-    digitalWrite(pin, HIGH);
-    delayMicroseconds(highMicros);
-    digitalWrite(pin, LOW);
-    delayMicroseconds(lowMicros);
-  }
-}
\ No newline at end of file
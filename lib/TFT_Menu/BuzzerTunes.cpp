@@ -0,0 +1,125 @@
+/**
+ * BuzzerTunes.cpp - 流式RTTTL读取器实现
+ */
+
+#include "BuzzerTunes.h"
+
+uint16_t buzzerInvalidNote() {
+  return 0;
+}
+
+BuzzerRtttlReader::BuzzerRtttlReader() {
+  _pos = NULL;
+  _duration = 4;
+  _octave = 6;
+  _bpm = 63;
+}
+
+char BuzzerRtttlReader::_peek() {
+  return (char)pgm_read_byte(_pos);
+}
+
+uint16_t BuzzerRtttlReader::_readNumber() {
+  uint16_t value = 0;
+  char c = _peek();
+  while (c >= '0' && c <= '9') {
+    value = value * 10 + (c - '0');
+    _pos++;
+    c = _peek();
+  }
+  return value;
+}
+
+void BuzzerRtttlReader::_skipSeparators() {
+  char c = _peek();
+  while (c == ',' || c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+    _pos++;
+    c = _peek();
+  }
+}
+
+bool BuzzerRtttlReader::begin(const char* rtttl) {
+  _pos = rtttl;
+  _duration = 4; // RTTTL规定的默认值
+  _octave = 6;
+  _bpm = 63;
+  if (_pos == NULL) return false;
+
+  // 跳过名称
+  char c = _peek();
+  while (c != ':' && c != '\0') {
+    _pos++;
+    c = _peek();
+  }
+  if (c != ':') return false;
+  _pos++;
+
+  // 默认参数 d=、o=、b=，以':'结束
+  _skipSeparators();
+  c = _peek();
+  while (c != ':' && c != '\0') {
+    char key = c;
+    _pos++;
+    if (_peek() != '=') return false;
+    _pos++;
+    uint16_t value = _readNumber();
+    if (key == 'd' || key == 'D') {
+      if (value > 0 && value <= 32) _duration = value;
+    } else if (key == 'o' || key == 'O') {
+      if (value <= 8) _octave = value;
+    } else if (key == 'b' || key == 'B') {
+      if (value > 0) _bpm = value;
+    }
+    _skipSeparators();
+    c = _peek();
+  }
+  if (c != ':') return false;
+  _pos++;
+  _skipSeparators();
+  return !done();
+}
+
+bool BuzzerRtttlReader::done() {
+  return _pos == NULL || _peek() == '\0';
+}
+
+bool BuzzerRtttlReader::next(BuzzerNote &note) {
+  if (done()) return false;
+
+  // 格式：[时值]音名[#][.][八度][.]
+  uint16_t division = _readNumber();
+  if (division == 0 || division > 32) division = _duration;
+
+  char c = _peek();
+  int semitone = -1;
+  bool rest = (c == 'p' || c == 'P');
+  if (!rest) {
+    semitone = buzzerSemitone(c);
+    if (semitone < 0) {
+      _pos = NULL; // 格式错误，停止读取
+      return false;
+    }
+  }
+  _pos++;
+
+  bool dotted = false;
+  if (_peek() == '#') {
+    semitone++;
+    _pos++;
+  }
+  if (_peek() == '.') {
+    dotted = true;
+    _pos++;
+  }
+  uint16_t octave = _readNumber();
+  if (octave == 0 || octave > 8) octave = _octave;
+  if (_peek() == '.') {
+    dotted = true;
+    _pos++;
+  }
+  _skipSeparators();
+
+  note.frequency = rest ? 0 : buzzerFrequency(semitone, octave);
+  note.duration = buzzerDuration((uint8_t)division, _bpm, dotted);
+  return true;
+}
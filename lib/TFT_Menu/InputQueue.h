@@ -0,0 +1,75 @@
+#ifndef INPUT_QUEUE_H
+#define INPUT_QUEUE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief Lock-free single-producer/single-consumer ring buffer.
+ *        The producer only writes the head index and the consumer only writes the tail index, so
+ *        push() may run in an ISR or another task while pop() runs in the main loop without locks.
+ *        Both indices run freely and are masked on access; one slot is never left unused.
+ *        push() and pop() are forced inline so a caller placed in IRAM stays in IRAM.
+ * @tparam T Element type (copied by value, keep it small).
+ * @tparam N Capacity, must be a power of two and at most 128.
+ */
+template <typename T, uint8_t N>
+class InputQueue {
+  static_assert(N > 0 && N <= 128 && (N & (N - 1)) == 0, "InputQueue capacity must be a power of two <= 128");
+
+public:
+  InputQueue() : _head(0), _tail(0) {}
+
+  /**
+   * @brief Appends an element (producer side).
+   * @param item The element to append.
+   * @return True if it was queued, false if the queue is full.
+   */
+  inline __attribute__((always_inline)) bool push(const T& item) {
+    uint8_t head = _head;
+    if ((uint8_t)(head - __atomic_load_n(&_tail, __ATOMIC_ACQUIRE)) >= N) return false;
+    _items[head & (N - 1)] = item;
+    __atomic_store_n(&_head, (uint8_t)(head + 1), __ATOMIC_RELEASE); // Publish the element after it is written
+    return true;
+  }
+
+  /**
+   * @brief Removes the oldest element (consumer side).
+   * @param item Receives the element.
+   * @return True if an element was removed, false if the queue is empty.
+   */
+  inline __attribute__((always_inline)) bool pop(T& item) {
+    uint8_t tail = _tail;
+    if (tail == __atomic_load_n(&_head, __ATOMIC_ACQUIRE)) return false;
+    item = _items[tail & (N - 1)];
+    __atomic_store_n(&_tail, (uint8_t)(tail + 1), __ATOMIC_RELEASE); // Free the slot after it is read
+    return true;
+  }
+
+  /**
+   * @brief Reads the oldest element without removing it (consumer side).
+   * @param item Receives the element.
+   * @return True if the queue is not empty.
+   */
+  inline __attribute__((always_inline)) bool peek(T& item) {
+    uint8_t tail = _tail;
+    if (tail == __atomic_load_n(&_head, __ATOMIC_ACQUIRE)) return false;
+    item = _items[tail & (N - 1)];
+    return true;
+  }
+
+  /**
+   * @brief Checks whether the queue is empty (exact on the consumer side).
+   * @return True if no element is queued.
+   */
+  inline bool empty() const {
+    return __atomic_load_n(&_head, __ATOMIC_ACQUIRE) == _tail;
+  }
+
+private:
+  T _items[N];
+  volatile uint8_t _head; // Next slot to write, owned by the producer
+  volatile uint8_t _tail; // Next slot to read, owned by the consumer
+};
+
+#endif
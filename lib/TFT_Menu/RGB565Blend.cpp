@@ -0,0 +1,136 @@
+#include "RGB565Blend.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef ARDUINO
+#include <Arduino.h> // micros() and IRAM_ATTR
+#else
+#include <chrono>
+static uint32_t micros() {
+  return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+#endif
+
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+
+/**
+ * @brief Blends one pixel with the same SWAR arithmetic (the pair's upper pixel is zero).
+ */
+static inline uint16_t blendPixel(uint16_t from, uint16_t to, uint8_t alpha, bool swapped) {
+  if (swapped) {
+    return (uint16_t)rgb565Swap2(rgb565Blend2(rgb565Swap2(from), rgb565Swap2(to), alpha));
+  }
+  return (uint16_t)rgb565Blend2(from, to, alpha);
+}
+
+#if defined(__XTENSA__)
+/**
+ * @brief Xtensa variant: runs from IRAM (no flash cache misses while the SPI bus is busy) and
+ *        processes four pixels per iteration so the loads of the second pair overlap the
+ *        multiplies of the first; the inverse factor is computed once per row.
+ */
+static void IRAM_ATTR blendWords(uint32_t* dst, const uint32_t* from, const uint32_t* to, size_t words, uint32_t alpha, bool swapped) {
+  const uint32_t inv = RGB565_BLEND_MAX - alpha;
+  size_t i = 0;
+  if (swapped) {
+    for (; i + 2 <= words; i += 2) {
+      uint32_t f0 = rgb565Swap2(from[i]), t0 = rgb565Swap2(to[i]);
+      uint32_t f1 = rgb565Swap2(from[i + 1]), t1 = rgb565Swap2(to[i + 1]);
+      uint32_t lo0 = (((f0 & RGB565_BLEND_MASK1) * inv + (t0 & RGB565_BLEND_MASK1) * alpha) >> 5) & RGB565_BLEND_MASK1;
+      uint32_t lo1 = (((f1 & RGB565_BLEND_MASK1) * inv + (t1 & RGB565_BLEND_MASK1) * alpha) >> 5) & RGB565_BLEND_MASK1;
+      uint32_t hi0 = ((((f0 >> 5) & RGB565_BLEND_MASK2) * inv + ((t0 >> 5) & RGB565_BLEND_MASK2) * alpha) >> 5) & RGB565_BLEND_MASK2;
+      uint32_t hi1 = ((((f1 >> 5) & RGB565_BLEND_MASK2) * inv + ((t1 >> 5) & RGB565_BLEND_MASK2) * alpha) >> 5) & RGB565_BLEND_MASK2;
+      dst[i] = rgb565Swap2(lo0 | (hi0 << 5));
+      dst[i + 1] = rgb565Swap2(lo1 | (hi1 << 5));
+    }
+  } else {
+    for (; i + 2 <= words; i += 2) {
+      uint32_t f0 = from[i], t0 = to[i];
+      uint32_t f1 = from[i + 1], t1 = to[i + 1];
+      uint32_t lo0 = (((f0 & RGB565_BLEND_MASK1) * inv + (t0 & RGB565_BLEND_MASK1) * alpha) >> 5) & RGB565_BLEND_MASK1;
+      uint32_t lo1 = (((f1 & RGB565_BLEND_MASK1) * inv + (t1 & RGB565_BLEND_MASK1) * alpha) >> 5) & RGB565_BLEND_MASK1;
+      uint32_t hi0 = ((((f0 >> 5) & RGB565_BLEND_MASK2) * inv + ((t0 >> 5) & RGB565_BLEND_MASK2) * alpha) >> 5) & RGB565_BLEND_MASK2;
+      uint32_t hi1 = ((((f1 >> 5) & RGB565_BLEND_MASK2) * inv + ((t1 >> 5) & RGB565_BLEND_MASK2) * alpha) >> 5) & RGB565_BLEND_MASK2;
+      dst[i] = lo0 | (hi0 << 5);
+      dst[i + 1] = lo1 | (hi1 << 5);
+    }
+  }
+  for (; i < words; i++) { // Odd word left over
+    dst[i] = swapped ? rgb565Swap2(rgb565Blend2(rgb565Swap2(from[i]), rgb565Swap2(to[i]), alpha))
+                     : rgb565Blend2(from[i], to[i], alpha);
+  }
+}
+#else
+/**
+ * @brief Portable variant: one pixel pair per iteration.
+ */
+static void blendWords(uint32_t* dst, const uint32_t* from, const uint32_t* to, size_t words, uint32_t alpha, bool swapped) {
+  if (swapped) {
+    for (size_t i = 0; i < words; i++) {
+      dst[i] = rgb565Swap2(rgb565Blend2(rgb565Swap2(from[i]), rgb565Swap2(to[i]), alpha));
+    }
+  } else {
+    for (size_t i = 0; i < words; i++) {
+      dst[i] = rgb565Blend2(from[i], to[i], alpha);
+    }
+  }
+}
+#endif
+
+void rgb565BlendRow(uint16_t* dst, const uint16_t* from, const uint16_t* to, size_t count, uint8_t alpha, bool swapped) {
+  if (alpha > RGB565_BLEND_MAX) alpha = RGB565_BLEND_MAX;
+
+  // Word access needs all three pointers on the same 32-bit alignment; otherwise stay per pixel
+  bool sameAlignment = (((uintptr_t)dst ^ (uintptr_t)from) & 3) == 0 && (((uintptr_t)dst ^ (uintptr_t)to) & 3) == 0;
+  if (!sameAlignment) {
+    for (size_t i = 0; i < count; i++) dst[i] = blendPixel(from[i], to[i], alpha, swapped);
+    return;
+  }
+
+  if (((uintptr_t)dst & 3) != 0 && count > 0) { // Leading pixel up to the word boundary
+    *dst++ = blendPixel(*from++, *to++, alpha, swapped);
+    count--;
+  }
+
+  size_t words = count / 2;
+  blendWords((uint32_t*)dst, (const uint32_t*)from, (const uint32_t*)to, words, alpha, swapped);
+
+  if (count & 1) { // Trailing pixel
+    size_t last = count - 1;
+    dst[last] = blendPixel(from[last], to[last], alpha, swapped);
+  }
+}
+
+uint32_t rgb565BlendBenchmark(uint16_t width, uint16_t height, uint16_t iterations) {
+  const uint16_t bandRows = 8;
+  size_t bandPixels = (size_t)width * bandRows;
+  uint16_t* from = (uint16_t*)malloc(bandPixels * sizeof(uint16_t));
+  uint16_t* to = (uint16_t*)malloc(bandPixels * sizeof(uint16_t));
+  uint16_t* dst = (uint16_t*)malloc(bandPixels * sizeof(uint16_t));
+  if (from == NULL || to == NULL || dst == NULL || iterations == 0) {
+    free(from); free(to); free(dst);
+    return 0;
+  }
+  for (size_t i = 0; i < bandPixels; i++) { // Arbitrary but non-trivial pixel data
+    from[i] = (uint16_t)(i * 2654435761UL >> 16);
+    to[i] = (uint16_t)~from[i];
+  }
+
+  volatile uint16_t sink = 0; // Keeps the blended output observable so the loop is not optimised away
+  uint32_t start = micros();
+  for (uint16_t n = 0; n < iterations; n++) {
+    uint8_t alpha = (uint8_t)(n % (RGB565_BLEND_MAX + 1));
+    for (uint16_t y = 0; y < height; y += bandRows) {
+      uint16_t rows = (height - y < bandRows) ? (height - y) : bandRows;
+      rgb565BlendRow(dst, from, to, (size_t)width * rows, alpha, true);
+      sink = sink + dst[y % bandPixels];
+    }
+  }
+  uint32_t elapsed = micros() - start;
+
+  free(from); free(to); free(dst);
+  return elapsed / iterations;
+}
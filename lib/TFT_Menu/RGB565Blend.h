@@ -0,0 +1,66 @@
+#ifndef RGB565_BLEND_H
+#define RGB565_BLEND_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief RGB565 blend kernel used by the fade transitions.
+ *        Two pixels are blended per 32-bit operation (SWAR): the six colour fields of a pixel pair
+ *        are split over two words with enough headroom between fields that each word can be
+ *        multiplied by the 5-bit blend factor without carries crossing field boundaries.
+ *        The kernel is plain C++ so it builds on the host; on Xtensa an unrolled IRAM variant is used.
+ */
+
+#define RGB565_BLEND_MAX 32 // Blend factor for "fully the second colour"
+
+// Word 1 holds B0, R0 and G1; word 2 holds (x >> 5): G0, B1 and R1. Each field has >= 5 spare bits above it.
+#define RGB565_BLEND_MASK1 0x07E0F81FUL
+#define RGB565_BLEND_MASK2 0x07C0F83FUL
+
+/**
+ * @brief Blends two pairs of RGB565 pixels packed in 32-bit words.
+ * @param from Two pixels of the first image (pixel 0 in the low half-word).
+ * @param to Two pixels of the second image.
+ * @param alpha Blend factor 0..RGB565_BLEND_MAX (0: from, 32: to).
+ * @return The two blended pixels.
+ */
+static inline uint32_t rgb565Blend2(uint32_t from, uint32_t to, uint32_t alpha) {
+  uint32_t inv = RGB565_BLEND_MAX - alpha;
+  uint32_t lo = (((from & RGB565_BLEND_MASK1) * inv + (to & RGB565_BLEND_MASK1) * alpha) >> 5) & RGB565_BLEND_MASK1;
+  uint32_t hi = ((((from >> 5) & RGB565_BLEND_MASK2) * inv + ((to >> 5) & RGB565_BLEND_MASK2) * alpha) >> 5) & RGB565_BLEND_MASK2;
+  return lo | (hi << 5);
+}
+
+/**
+ * @brief Swaps the bytes of both half-words (panel/sprite byte order <-> native RGB565).
+ * @param x Two packed pixels.
+ * @return The two pixels with their bytes swapped.
+ */
+static inline uint32_t rgb565Swap2(uint32_t x) {
+  return ((x & 0x00FF00FFUL) << 8) | ((x >> 8) & 0x00FF00FFUL);
+}
+
+/**
+ * @brief Blends a run of RGB565 pixels: dst[i] = from[i] * (1 - alpha/32) + to[i] * alpha/32.
+ *        dst may alias from or to.
+ * @param dst Destination pixels.
+ * @param from Pixels of the first image.
+ * @param to Pixels of the second image.
+ * @param count Number of pixels.
+ * @param alpha Blend factor 0..RGB565_BLEND_MAX.
+ * @param swapped True if pixels are stored byte-swapped (TFT_eSprite / panel order).
+ */
+void rgb565BlendRow(uint16_t* dst, const uint16_t* from, const uint16_t* to, size_t count, uint8_t alpha, bool swapped);
+
+/**
+ * @brief Measures the blend kernel throughput for one full frame.
+ *        Blends a width x height frame `iterations` times from a band buffer and reports the average.
+ * @param width Frame width in pixels.
+ * @param height Frame height in pixels.
+ * @param iterations Number of full-frame blends to average over.
+ * @return Average time for one full-frame blend step in microseconds, 0 if buffers could not be allocated.
+ */
+uint32_t rgb565BlendBenchmark(uint16_t width, uint16_t height, uint16_t iterations);
+
+#endif // RGB565_BLEND_H
@@ -1,4 +1,5 @@
 #include "TFT_Menu.h"
+#include "RGB565Blend.h"
 #include <algorithm> // For std::max and std::min
 #include <math.h>    // For fmod
 
@@ -76,6 +77,15 @@ MenuSystem::MenuSystem(TFT_eSPI* _tft, Buzzer* _buzzer) {
   selectedIndex = 0; // Index of the currently selected item
   startIndex = 0; // Starting index of visible menu items
   menuLevel = 0; // Current menu depth
+  pendingSelectDelta = 0; // Net selection steps queued since the last frame
+  inputOverflowSteps = 0; // Navigation steps that did not fit in the input queue
+
+  //----------------Navigation Acceleration Initialization----------------//
+  _navAccelMaxStep = 10;     // Max items per detent
+  _navAccelThreshold = 8.0f; // Detents per second before acceleration starts
+  _navVelocity = 0.0f;
+  _navLastTime = 0;
+  _navLastDirection = 0;
   lastTitle = ""; // Last drawn title string
 
   titleBottomMargin = 10; // Margin below the title area
@@ -101,6 +111,11 @@ MenuSystem::MenuSystem(TFT_eSPI* _tft, Buzzer* _buzzer) {
   animInterval = 15;  // ms (Target ~60fps)
   _animationForm = 1; // Default animation form is Precise Control mode
 
+  //----------------Adaptive Rendering Quality Initialization----------------//
+  _adaptiveQuality = true;
+  _frameBudget = 0; // 0: use animInterval as the frame budget
+  _renderQuality = RENDER_QUALITY_FULL;
+
   // Slider animation state initialization
   // These initial values will be updated after calculateLayoutParameters(), but set defaults first
   sliderAnim.x_cur = menuItemsXOffset;
@@ -125,6 +140,17 @@ MenuSystem::MenuSystem(TFT_eSPI* _tft, Buzzer* _buzzer) {
   titleDecoratorAnim.x_err = 0.0f;
   currentTitleDecoratorX = 0; // Set in calculateLayoutParameters
 
+  //----------------Page Transition Initialization----------------//
+  _pageTransition = PAGE_TRANSITION_NONE;
+  activePageTransition = PAGE_TRANSITION_NONE;
+  pageTransitionActive = false;
+  pageTransitionDirection = 1;
+  lastPageTransitionTime = 0;
+  _pageOut = NULL;
+  _pageIn = NULL;
+  _pageBand = NULL;
+  _pageBytesPerPixel = 0;
+
   //----------------Anti-Flicker Initialization----------------//
   lastSelectedIndex = -1;
   lastStartIndex = -1;
@@ -147,15 +173,17 @@ MenuSystem::MenuSystem(TFT_eSPI* _tft, Buzzer* _buzzer) {
  * @brief Destructor for the MenuSystem.
  */
 MenuSystem::~MenuSystem() {
-  // Destructor implementation (if any dynamic memory allocation was used)
+  releasePageBuffers(); // Page transition buffers are the only dynamic allocations
 }
 
 /**
- * @brief Initializes the buzzer.
+ * @brief Initializes the buzzer in asynchronous mode, so feedback sounds never stall navigation.
+ *        The tones are stopped by Buzzer::service(), which update() calls every frame.
  */
 void MenuSystem::buzzer_begin(){
   buzzer->begin();
   buzzer->setVolume(buzz_vol);
+  buzzer->setAsync(true);
 }
 
 /**
@@ -337,6 +365,7 @@ void MenuSystem::updateAnimation(bool type) {
     // Only redraw if slider position or size has actually changed
     if (round(sliderAnim.x_cur) != oldX || round(sliderAnim.y_cur) != oldY || 
         round(sliderAnim.w_cur) != oldWidth || round(sliderAnim.h_cur) != oldHeight) {
+      unsigned long frameStart = micros(); // Frame timing for adaptive rendering quality
       
       // 1. Clear the background of the previous slider position
       if (lastSelectedRect.valid) {
@@ -363,10 +392,17 @@ void MenuSystem::updateAnimation(bool type) {
       lastSelectedRect.width = round(sliderAnim.w_cur) + 2 * menuItemBorderOffset;
       lastSelectedRect.height = round(sliderAnim.h_cur) + 2 * menuItemBorderOffset;
       lastSelectedRect.valid = true;
+
+      // 5. If this frame overran the budget, step down quality for the rest of the animation
+      unsigned long budgetMicros = 1000UL * (_frameBudget > 0 ? _frameBudget : animInterval);
+      if (_adaptiveQuality && micros() - frameStart > budgetMicros && _renderQuality < RENDER_QUALITY_NO_TEXT) {
+        _renderQuality = (RenderQuality)(_renderQuality + 1);
+      }
     }
     
     if (xDone && yDone && wDone && hDone) { // If all animations are complete
       animationActive = false;
+      _renderQuality = RENDER_QUALITY_FULL; // The settled frame is always drawn at full quality
       needFullRedraw = true; // Force a full redraw after animation ends to ensure a clean screen state
     }
   }
@@ -384,13 +420,11 @@ void MenuSystem::drawAnimatedSlider() {
   int animWidth = round(sliderAnim.w_cur);
   int animHeight = round(sliderAnim.h_cur);
 
-  // Draw background rounded rectangle with highlight color
-  tft->fillRoundRect(animX, animY, animWidth, animHeight, menuItemCornerRadius, highlightColor);
-  
-  // Draw border rounded rectangle with border color
-  tft->drawRoundRect(animX - menuItemBorderOffset, animY - menuItemBorderOffset, 
-                     animWidth + 2 * menuItemBorderOffset, animHeight + 2 * menuItemBorderOffset, 
-                     menuItemCornerRadius + menuItemBorderOffset, borderColor);
+  // Draw background and border at the current render quality
+  drawAnimatedFrame(animX, animY, animWidth, animHeight);
+
+  // At the lowest quality the item content is only drawn on the settled frame
+  if (_renderQuality >= RENDER_QUALITY_NO_TEXT) return;
   
   // Draw selected item's text, decorator, and arrow (these now move with the slider)
   String itemText = currentMenu[selectedIndex].getLabel();
@@ -432,13 +466,36 @@ void MenuSystem::drawAnimatedWindow() {
   int animWidth = round(sliderAnim.w_cur);
   int animHeight = round(sliderAnim.h_cur);
 
-  // Draw background rounded rectangle with highlight color
-  tft->fillRoundRect(animX, animY, animWidth, animHeight, menuItemCornerRadius, highlightColor);
-  
-  // Draw border rounded rectangle with border color
-  tft->drawRoundRect(animX - menuItemBorderOffset, animY - menuItemBorderOffset, 
-                     animWidth + 2 * menuItemBorderOffset, animHeight + 2 * menuItemBorderOffset, 
-                     menuItemCornerRadius + menuItemBorderOffset, borderColor);
+  // Draw background and border at the current render quality
+  drawAnimatedFrame(animX, animY, animWidth, animHeight);
+}
+
+/**
+ * @brief Draws the highlight background and border of the slider or window at the current render quality.
+ * @param x X coordinate.
+ * @param y Y coordinate.
+ * @param width Width of the area.
+ * @param height Height of the area.
+ */
+void MenuSystem::drawAnimatedFrame(int x, int y, int width, int height) {
+  if (_renderQuality == RENDER_QUALITY_FULL) {
+    // Draw background rounded rectangle with highlight color
+    tft->fillRoundRect(x, y, width, height, menuItemCornerRadius, highlightColor);
+    
+    // Draw border rounded rectangle with border color
+    tft->drawRoundRect(x - menuItemBorderOffset, y - menuItemBorderOffset, 
+                       width + 2 * menuItemBorderOffset, height + 2 * menuItemBorderOffset, 
+                       menuItemCornerRadius + menuItemBorderOffset, borderColor);
+    return;
+  }
+
+  // Reduced quality: plain rectangles are much cheaper to push than rounded corners
+  tft->fillRect(x, y, width, height, highlightColor);
+  if (_renderQuality == RENDER_QUALITY_PLAIN_RECT) {
+    tft->drawRect(x - menuItemBorderOffset, y - menuItemBorderOffset, 
+                  width + 2 * menuItemBorderOffset, height + 2 * menuItemBorderOffset, 
+                  borderColor);
+  }
 }
 
 /**
@@ -454,6 +511,7 @@ void MenuSystem::startAnimation(int targetX, int targetY, int targetWidth, int t
   sliderAnim.w_tgt = targetWidth;
   sliderAnim.h_tgt = targetHeight;
   
+  if (!animationActive) _renderQuality = RENDER_QUALITY_FULL; // Each new animation starts at full quality
   animationActive = true;
   lastAnimTime = millis();
 }
@@ -481,8 +539,8 @@ void MenuSystem::setRootMenu(MenuItem* menu, uint8_t size) {
 
     sliderAnim.x_tgt = initialRect.x; // Target also set to current position, no animation
     sliderAnim.y_tgt = initialRect.y;
-    sliderAnim.w_tgt = initialRect.w_cur;
-    sliderAnim.h_tgt = initialRect.h_cur;
+    sliderAnim.w_tgt = initialRect.width;
+    sliderAnim.h_tgt = initialRect.height;
   } else { // If menu is empty, slider returns to default position
     sliderAnim.x_cur = menuItemsXOffset;
     sliderAnim.y_cur = menuItemsAreaY;
@@ -496,6 +554,7 @@ void MenuSystem::setRootMenu(MenuItem* menu, uint8_t size) {
   }
   
   needFullRedraw = true;
+  pendingSelectDelta = 0;
   lastSelectedIndex = -1;
   lastStartIndex = -1;
   lastTitle = "";
@@ -697,6 +756,7 @@ void MenuSystem::optimizeMemoryUsage() {
  * @param forceRedraw If true, forces a complete redraw of the screen.
  */
 void MenuSystem::drawMenu(bool forceRedraw) {
+  if (!animationActive) _renderQuality = RENDER_QUALITY_FULL; // Static frames are always drawn at full quality
   if (forceRedraw || needFullRedraw) { // Only perform full redraw when necessary
     tft->fillScreen(backgroundColor); // Clear screen
     needFullRedraw = true; // Ensure all components redraw
@@ -738,85 +798,105 @@ void MenuSystem::updateTitleDecoratorAnimation() {
 
 /**
  * @brief Moves the selection to the next menu item.
+ *        The step is queued as an intent and applied at the next frame boundary in update().
  */
 void MenuSystem::selectNext() {
-  if (currentMenuSize == 0 || selectedIndex >= currentMenuSize - 1) return;
-  if(BanOperation == true) return; // If operation is banned, return immediately
-  selectedIndex++; // Select next menu item
-  buzzer->beep(20,1000,buzz_vol); 
+  queueSelectDelta(1);
+}
 
-  // During scroll operations, smooth animation is usually not desired; jump to new position immediately
-  if (_sliderDisplayMode == SLIDER_DISPLAY_FIXED_TOP) {
-    startIndex = selectedIndex; // Force selected item to the top
-    needFullRedraw = true; // Force full redraw to update scroll position
-    // Immediately set slider current position to target position, avoiding animation during scroll
-    RectF targetRect = calculateSliderTargetRect(selectedIndex);
-    sliderAnim.x_cur = targetRect.x;
-    sliderAnim.y_cur = targetRect.y;
-    sliderAnim.w_cur = targetRect.width; 
-    sliderAnim.h_cur = targetRect.height; 
-    animationActive = false; // Disable animation as it's an immediate scroll
-    return;
-  }
+/**
+ * @brief Moves the selection to the previous menu item.
+ *        The step is queued as an intent and applied at the next frame boundary in update().
+ */
+void MenuSystem::selectPrev() {
+  queueSelectDelta(-1);
+}
 
-  // Scrolling logic for SLIDER_DISPLAY_FOLLOW_SELECTION mode
-  if (selectedIndex >= startIndex + actualMaxDisplayItems) {
-    startIndex = selectedIndex - actualMaxDisplayItems + 1;
-    needFullRedraw = true; // Force full redraw to update scroll position
-    // Immediately set slider current position to target position, avoiding animation during scroll
-    RectF targetRect = calculateSliderTargetRect(selectedIndex);
-    sliderAnim.x_cur = targetRect.x;
-    sliderAnim.y_cur = targetRect.y;
-    sliderAnim.w_cur = targetRect.width; 
-    sliderAnim.h_cur = targetRect.height; 
-    animationActive = false; // Disable animation as it's an immediate scroll
-    return;
+/**
+ * @brief Moves the selection by an encoder step delta, with velocity-based acceleration.
+ *        Slow rotation moves one item per detent; fast rotation jumps several items per detent.
+ * @param steps Signed number of detents since the last call (positive moves to the next items).
+ * @param timestamp Time of the steps in ms (e.g. millis()).
+ */
+void MenuSystem::navigate(int16_t steps, unsigned long timestamp) {
+  if (steps == 0) return;
+
+  // Estimate rotation speed (detents per second). A pause or direction change restarts the estimate.
+  unsigned long dt = timestamp - _navLastTime;
+  bool sameDirection = (steps > 0) == (_navLastDirection > 0);
+  if (_navLastTime == 0 || dt > 250 || !sameDirection) {
+    _navVelocity = 0.0f;
+  } else {
+    float instantVelocity = abs(steps) * 1000.0f / std::max(1UL, dt);
+    _navVelocity = _navVelocity * 0.6f + instantVelocity * 0.4f; // Smooth out detent jitter
   }
-  
-  // If no scrolling, initiate animation
-  RectF targetRect = calculateSliderTargetRect(selectedIndex);
-  startAnimation(targetRect.x, targetRect.y, targetRect.width, targetRect.height);
+  _navLastTime = timestamp;
+  _navLastDirection = (steps > 0) ? 1 : -1;
+
+  // Acceleration curve: 1 item per detent below the threshold, then grows quadratically up to the cap
+  int16_t itemsPerStep = 1;
+  if (_navVelocity > _navAccelThreshold && _navAccelMaxStep > 1) {
+    float excess = (_navVelocity - _navAccelThreshold) / _navAccelThreshold;
+    itemsPerStep = std::min((int)_navAccelMaxStep, 1 + (int)(excess * excess * _navAccelMaxStep));
+  }
+
+  queueSelectDelta(steps * itemsPerStep); // Applied as one jump (one animation/redraw) at the next frame
 }
 
 /**
- * @brief Moves the selection to the previous menu item.
+ * @brief Queues a selection delta, coalesced with other queued steps in applyPendingSelection.
+ * @param delta Signed number of items to move.
  */
-void MenuSystem::selectPrev() {
-  if (currentMenuSize == 0 || selectedIndex == 0) return;
+void MenuSystem::queueSelectDelta(int16_t delta) {
+  if (currentMenuSize == 0) return;
   if(BanOperation == true) return; // If operation is banned, return immediately
-  selectedIndex--;
-  buzzer->beep(20,1000,buzz_vol); 
+  pendingSelectDelta = constrain(pendingSelectDelta + delta, -(int16_t)currentMenuSize, (int16_t)currentMenuSize);
+}
+
+/**
+ * @brief Applies all queued selection intents as one net delta.
+ *        Called once per frame, so any number of inputs results in at most one beep,
+ *        one slider retarget and one scroll redraw.
+ */
+void MenuSystem::applyPendingSelection() {
+  if (pendingSelectDelta == 0) return;
+  int16_t delta = pendingSelectDelta;
+  pendingSelectDelta = 0;
+  if (currentMenuSize == 0 || BanOperation == true) return;
+
+  int16_t newIndex = constrain((int16_t)selectedIndex + delta, 0, (int16_t)currentMenuSize - 1);
+  if (newIndex == selectedIndex) return; // Already at the end of the list
+  selectedIndex = newIndex;
+  buzzer->feedback(BUZZER_EVENT_NAVIGATE); // Rate-limited and coalesced by the buzzer's feedback mixer
 
   // During scroll operations, smooth animation is usually not desired; jump to new position immediately
+  bool scrolled = false;
   if (_sliderDisplayMode == SLIDER_DISPLAY_FIXED_TOP) {
     startIndex = selectedIndex; // Force selected item to the top
-    needFullRedraw = true; // Force full redraw to update scroll position
-    // Immediately set slider current position to target position
-    RectF targetRect = calculateSliderTargetRect(selectedIndex);
-    sliderAnim.x_cur = targetRect.x;
-    sliderAnim.y_cur = targetRect.y;
-    sliderAnim.w_cur = targetRect.width; 
-    sliderAnim.h_cur = targetRect.height; 
-    animationActive = false; // Disable animation
-    return;
+    scrolled = true;
+  } else if (selectedIndex >= startIndex + actualMaxDisplayItems) { // Scrolling logic for SLIDER_DISPLAY_FOLLOW_SELECTION mode
+    startIndex = selectedIndex - actualMaxDisplayItems + 1;
+    scrolled = true;
+  } else if (selectedIndex < startIndex) {
+    startIndex = selectedIndex;
+    scrolled = true;
   }
 
-  // Scrolling logic for SLIDER_DISPLAY_FOLLOW_SELECTION mode
-  if (selectedIndex < startIndex) {
-    startIndex = selectedIndex;
+  RectF targetRect = calculateSliderTargetRect(selectedIndex);
+  if (scrolled) {
     needFullRedraw = true; // Force full redraw to update scroll position
-    // Immediately set slider current position to target position
-    RectF targetRect = calculateSliderTargetRect(selectedIndex);
-    sliderAnim.x_cur = targetRect.x;
-    sliderAnim.y_cur = targetRect.y;
-    sliderAnim.w_cur = targetRect.width; 
-    sliderAnim.h_cur = targetRect.height; 
-    animationActive = false; // Disable animation
+    // Immediately set slider current position to target position, avoiding animation during scroll
+    sliderAnim.x_cur = sliderAnim.x_tgt = targetRect.x;
+    sliderAnim.y_cur = sliderAnim.y_tgt = targetRect.y;
+    sliderAnim.w_cur = sliderAnim.w_tgt = targetRect.width; 
+    sliderAnim.h_cur = sliderAnim.h_tgt = targetRect.height; 
+    sliderAnim.x_vel = sliderAnim.y_vel = sliderAnim.w_vel = sliderAnim.h_vel = 0.0f;
+    animationActive = false; // Disable animation as it's an immediate scroll
     return;
   }
-
-  // If no scrolling, initiate animation
-  RectF targetRect = calculateSliderTargetRect(selectedIndex);
+  
+  // If no scrolling, initiate animation. An in-flight animation is retargeted:
+  // current position, velocity and error terms are kept, so motion stays continuous.
   startAnimation(targetRect.x, targetRect.y, targetRect.width, targetRect.height);
 }
 
@@ -824,10 +904,12 @@ void MenuSystem::selectPrev() {
  * @brief Confirms the selection of the current menu item, executing its callback or entering its submenu.
  */
 void MenuSystem::select() {
+  if (pageTransitionActive) return; // Ignore input while pages are sliding
+  applyPendingSelection(); // Confirm the item the user actually scrolled to
   if (!currentMenu || selectedIndex >= currentMenuSize) return;
   if(BanOperation == true) return; // If operation is banned, return immediately
   MenuItem selectedItem = currentMenu[selectedIndex];
-  buzzer->beep(20,1000,buzz_vol);
+  buzzer->feedback(BUZZER_EVENT_SELECT);
    
   if (selectedItem.getCallback() != NULL) {
       selectedItem.getCallback()();
@@ -837,6 +919,7 @@ void MenuSystem::select() {
         case 0:break;
         case 1:{
             Serial.println("Scroll");
+            bool fading = beginPageTransition(true); // Capture the page before the window opens
             type = 1; // Set flag for window animation
 
             uint16_t WinStartX = screenWidth*0.05;
@@ -852,6 +935,7 @@ void MenuSystem::select() {
             }
             
             startAnimation(targetRect.x, targetRect.y, targetRect.width, targetRect.height);
+            if (fading) startPageTransition(0); // Fade the window in instead of growing it
 
             TypeNum = 0;
             BanOperation = true; // Ban operations during this specific animation
@@ -868,6 +952,7 @@ void MenuSystem::select() {
   
   if (selectedItem.hasSubMenu()) {
     if (menuLevel < 9) { // Max 10 levels (0-9)
+        bool sliding = beginPageTransition(); // Capture the outgoing page before the menu changes
         menuHistory[menuLevel] = currentMenu; // Save current menu
         menuSizeHistory[menuLevel] = currentMenuSize; // Save current menu size
         selectedIndexHistory[menuLevel] = selectedIndex; // Save current index
@@ -913,6 +998,8 @@ void MenuSystem::select() {
         currentTitleDecoratorX = screenWidth; // Initialize current drawing position
         titleDecoratorAnimationActive = true;
         lastTitleDecoratorAnimTime = millis();
+
+        if (sliding) startPageTransition(1); // New page slides in from the right
     }
   }
 }
@@ -921,10 +1008,13 @@ void MenuSystem::select() {
  * @brief Returns to the previous menu level.
  */
 void MenuSystem::back() {
+  if (pageTransitionActive) return; // Ignore input while pages are sliding
+  pendingSelectDelta = 0; // Queued steps belong to the menu being left
   if (menuLevel > 0) { // If current menu level is greater than 0
     if(type == 0){ // If not in a special window animation mode
+        bool sliding = beginPageTransition(); // Capture the outgoing page before the menu changes
         menuLevel--; // Go back to previous menu level
-        buzzer->longBeep(100,1000,buzz_vol); // Long beep
+        buzzer->feedback(BUZZER_EVENT_BACK); // Long beep
         currentMenu = menuHistory[menuLevel]; // Get previous menu
         currentMenuSize = menuSizeHistory[menuLevel]; // Get previous menu size
         selectedIndex = selectedIndexHistory[menuLevel]; // Get previous menu's selected index
@@ -975,22 +1065,151 @@ void MenuSystem::back() {
         currentTitleDecoratorX = -titleDecoratorW; // Initialize current drawing position
         titleDecoratorAnimationActive = true;
         lastTitleDecoratorAnimTime = millis();
+
+        if (sliding) startPageTransition(-1); // Parent page slides in from the left
         }
     else{ // If currently in a special window animation mode, just exit that mode
+        bool fading = beginPageTransition(true); // Capture the page with the window still open
         type = 0; // Revert to normal menu item animation
-        buzzer->longBeep(100,1000,buzz_vol); // Long beep
+        buzzer->feedback(BUZZER_EVENT_BACK); // Long beep
         RectF targetRect = calculateSliderTargetRect(selectedIndex);
         startAnimation(targetRect.x, targetRect.y, targetRect.width, targetRect.height);
+        if (fading) startPageTransition(0); // Fade the window out instead of shrinking it
         BanOperation = false; // Re-enable operations
         }
     }
 }
 
+/**
+ * @brief Posts an input event to be applied at the start of the next update().
+ *        Single producer: one ISR or one input task. Kept in IRAM so it can be called from GPIO/PCNT ISRs.
+ * @param type The input event type.
+ * @param value Event argument (signed detents for MENU_INPUT_NAVIGATE).
+ * @param timestamp Time of the input in ms.
+ * @return False if a select/back event was dropped because the queue is full.
+ */
+bool IRAM_ATTR MenuSystem::postInput(MenuInputType type, int16_t value, unsigned long timestamp) {
+  MenuInputEvent event;
+  event.timestamp = (uint32_t)timestamp;
+  event.value = value;
+  event.type = type;
+  // Earlier overflowed steps go into the queue first, so no later event can overtake them
+  bool queued = flushInputOverflow(event.timestamp) && inputQueue.push(event);
+  if (!queued && type == MENU_INPUT_NAVIGATE) {
+    __atomic_fetch_add(&inputOverflowSteps, (int32_t)value, __ATOMIC_RELAXED);
+    queued = true;
+  }
+  wake();
+  return queued;
+}
+
+/**
+ * @brief Moves the overflowed navigation steps into the queue as one navigation event.
+ *        Producer side of postInput(); the steps are taken atomically so drainInput() cannot apply them twice.
+ * @param timestamp Time stamped on the navigation event.
+ * @return True if no overflowed steps remain.
+ */
+bool IRAM_ATTR MenuSystem::flushInputOverflow(uint32_t timestamp) {
+  int32_t steps = __atomic_exchange_n(&inputOverflowSteps, 0, __ATOMIC_RELAXED);
+  if (steps == 0) return true;
+  MenuInputEvent event;
+  event.timestamp = timestamp;
+  event.value = (int16_t)constrain(steps, -32767, 32767);
+  event.type = MENU_INPUT_NAVIGATE;
+  if (inputQueue.push(event)) return true;
+  __atomic_fetch_add(&inputOverflowSteps, steps, __ATOMIC_RELAXED); // Still full: keep them for the next post
+  return false;
+}
+
+void* volatile MenuSystem::_waitingTask = NULL;
+
+/**
+ * @brief Checks whether update() has nothing to do until new input arrives.
+ * @return True if no animation, transition, redraw, queued input or buzzer activity is pending.
+ */
+bool MenuSystem::isIdle() {
+  return !animationActive && !titleDecoratorAnimationActive && !pageTransitionActive && !needFullRedraw &&
+         pendingSelectDelta == 0 && inputOverflowSteps == 0 && inputQueue.empty() && !buzzer->isBusy();
+}
+
+/**
+ * @brief Blocks the calling task while the menu is idle, until input is posted, wake() is called or maxMs elapses.
+ * @param maxMs Maximum time to wait in ms.
+ * @return True if woken by input, false on timeout or if the menu was not idle.
+ */
+bool MenuSystem::waitForActivity(uint32_t maxMs) {
+#if defined(ARDUINO_ARCH_ESP32)
+  _waitingTask = xTaskGetCurrentTaskHandle();
+  // Re-check after publishing the task handle: input posted in between must not be slept through
+  if (!isIdle()) {
+    _waitingTask = NULL;
+    ulTaskNotifyTake(pdTRUE, 0); // Drop a notification given before the check
+    return false;
+  }
+  bool woken = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(maxMs)) > 0;
+  _waitingTask = NULL;
+  return woken;
+#else
+  return false;
+#endif
+}
+
+/**
+ * @brief Wakes a task blocked in waitForActivity(). Safe to call from an ISR or any task.
+ */
+void IRAM_ATTR MenuSystem::wake() {
+#if defined(ARDUINO_ARCH_ESP32)
+  TaskHandle_t task = (TaskHandle_t)_waitingTask;
+  if (task == NULL) return;
+  if (xPortInIsrContext()) {
+    BaseType_t higherPriorityWoken = pdFALSE;
+    vTaskNotifyGiveFromISR(task, &higherPriorityWoken);
+    if (higherPriorityWoken) portYIELD_FROM_ISR();
+  } else {
+    xTaskNotifyGive(task);
+  }
+#endif
+}
+
+/**
+ * @brief Applies the events posted by postInput() in order.
+ *        Select/back events stay queued while a page transition is running, so they are applied after it.
+ */
+void MenuSystem::drainInput() {
+  MenuInputEvent event;
+  while (inputQueue.peek(event)) {
+    if (event.type != MENU_INPUT_NAVIGATE && pageTransitionActive) return; // Keep order: wait for the transition
+    inputQueue.pop(event);
+    switch (event.type) {
+      case MENU_INPUT_NAVIGATE: navigate(event.value, event.timestamp); break;
+      case MENU_INPUT_SELECT:   select(); break;
+      case MENU_INPUT_BACK:     back(); break;
+    }
+  }
+  // Queue empty: overflowed steps left behind by the last post came after every queued event
+  int32_t steps = __atomic_exchange_n(&inputOverflowSteps, 0, __ATOMIC_RELAXED);
+  if (steps != 0) navigate((int16_t)constrain(steps, -32767, 32767), millis());
+}
+
 /**
  * @brief Updates the menu display, including animations.
  *        This function should be called frequently in the main loop.
  */
 void MenuSystem::update() {
+  buzzer->service(); // Stop asynchronous feedback tones when they expire
+
+  // Frame start: apply input posted since the last frame, in order
+  drainInput();
+
+  // A page transition owns the whole screen; queued input is applied once it has finished
+  if (pageTransitionActive) {
+    updatePageTransition();
+    return;
+  }
+
+  // Frame boundary: coalesce all selection intents queued since the last frame
+  applyPendingSelection();
+
   // Prioritize animation updates
   if (animationActive) { // Slider animation
     if(type == 1){updateAnimation(1);} // Special window animation
@@ -1008,6 +1227,204 @@ void MenuSystem::update() {
   // Otherwise, no drawing operations are performed to save CPU cycles.
 }
 
+//------------------------------------Page Transitions------------------------------------//
+
+/**
+ * @brief Allocates the page buffers and renders the outgoing page into them.
+ *        Must be called before the menu state changes.
+ * @param popup True for the popup window (type == 1) path, which only supports the fade transition.
+ * @return True if a page transition can be run, false to fall back to a plain redraw.
+ */
+bool MenuSystem::beginPageTransition(bool popup) {
+  if (_pageTransition == PAGE_TRANSITION_NONE) return false;
+  if (popup && _pageTransition != PAGE_TRANSITION_FADE) return false;
+  // Blending needs exact RGB565 pages; sliding can fall back to RGB332
+  PageTransition transition = _pageTransition;
+  if (!allocatePageBuffers(transition != PAGE_TRANSITION_FADE)) {
+    // Two RGB565 pages (150 KB each at 240x320) only fit with PSRAM: slide with RGB332 pages instead of fading.
+    // The popup window has no slide, so it keeps its grow/shrink animation.
+    if (transition != PAGE_TRANSITION_FADE || popup || !allocatePageBuffers(true)) return false; // Plain redraw
+    transition = PAGE_TRANSITION_SLIDE;
+  }
+  activePageTransition = transition;
+
+  renderPage(_pageOut);
+  return true;
+}
+
+/**
+ * @brief Renders the incoming page and starts the transition animation.
+ *        Must be called after the menu state has changed.
+ * @param direction 1 when entering a submenu (page comes from the right), -1 when going back, 0 for the popup window.
+ */
+void MenuSystem::startPageTransition(int8_t direction) {
+  // The incoming page is shown settled: the slider sits on its target and the title decorator is static
+  sliderAnim.x_cur = sliderAnim.x_tgt;
+  sliderAnim.y_cur = sliderAnim.y_tgt;
+  sliderAnim.w_cur = sliderAnim.w_tgt;
+  sliderAnim.h_cur = sliderAnim.h_tgt;
+  sliderAnim.x_vel = sliderAnim.y_vel = sliderAnim.w_vel = sliderAnim.h_vel = 0.0f;
+  sliderAnim.x_err = sliderAnim.y_err = sliderAnim.w_err = sliderAnim.h_err = 0.0f;
+  animationActive = false;
+  titleDecoratorAnimationActive = false;
+  currentTitleDecoratorX = titleDecoratorX;
+  titleDecoratorAnim.x_cur = titleDecoratorX;
+
+  renderPage(_pageIn);
+
+  // The next slider move must clear the settled slider of the new page, not the outgoing page's slider
+  lastSelectedRect.x = round(sliderAnim.x_cur) - menuItemBorderOffset;
+  lastSelectedRect.y = round(sliderAnim.y_cur) - menuItemBorderOffset;
+  lastSelectedRect.width = round(sliderAnim.w_cur) + 2 * menuItemBorderOffset;
+  lastSelectedRect.height = round(sliderAnim.h_cur) + 2 * menuItemBorderOffset;
+  lastSelectedRect.valid = true;
+
+  pageTransitionAnim.x_cur = 0.0f;          // Progress in pixels of horizontal offset
+  pageTransitionAnim.x_tgt = screenWidth;
+  pageTransitionAnim.x_vel = 0.0f;
+  pageTransitionAnim.x_err = 0.0f;
+  pageTransitionDirection = direction;
+  pageTransitionActive = true;
+  lastPageTransitionTime = millis();
+}
+
+/**
+ * @brief Advances the page transition and composes one frame from the page buffers.
+ */
+void MenuSystem::updatePageTransition() {
+  unsigned long currentTime = millis();
+  if (currentTime - lastPageTransitionTime < animInterval) return;
+
+  float deltaTime = (currentTime - lastPageTransitionTime) / 1000.0f;
+  if (deltaTime > 0.1f) deltaTime = 0.1f; // Cap max step to 100ms to prevent large jumps after lag
+  lastPageTransitionTime = currentTime;
+
+  bool done = animateSingleValue(&pageTransitionAnim.x_cur, &pageTransitionAnim.x_tgt,
+                                 &pageTransitionAnim.x_vel, &pageTransitionAnim.x_err, deltaTime);
+  int offset = constrain((int)round(pageTransitionAnim.x_cur), 0, (int)screenWidth); // Underdamped form may overshoot
+
+  if (activePageTransition == PAGE_TRANSITION_FADE) {
+    composeFadeFrame(offset * RGB565_BLEND_MAX / screenWidth);
+  } else {
+    composePageFrame(offset);
+  }
+
+  if (done) {
+    pageTransitionActive = false;
+    // 8-bit page buffers only approximate the palette; redraw once with exact colors
+    if (_pageBytesPerPixel == 1) needFullRedraw = true;
+    releasePageBuffers();
+  }
+}
+
+/**
+ * @brief Composes one transition frame by offset blits of the two page buffers.
+ *        Each band of rows is assembled with two memcpy per row and pushed in one block,
+ *        so a frame costs exactly one screen of pixel pushes.
+ * @param offset Horizontal offset in pixels (0: outgoing page, screenWidth: incoming page).
+ */
+void MenuSystem::composePageFrame(int offset) {
+  const uint8_t* outPixels = (const uint8_t*)_pageOut->getPointer();
+  const uint8_t* inPixels = (const uint8_t*)_pageIn->getPointer();
+  const size_t rowBytes = (size_t)screenWidth * _pageBytesPerPixel;
+  const size_t offsetBytes = (size_t)offset * _pageBytesPerPixel;
+
+  // Entering: content moves left, incoming page appears at the right edge.
+  // Going back: content moves right, incoming page appears at the left edge.
+  const uint8_t* leftPage = (pageTransitionDirection > 0) ? outPixels : inPixels;
+  const uint8_t* rightPage = (pageTransitionDirection > 0) ? inPixels : outPixels;
+  const size_t leftStart = (pageTransitionDirection > 0) ? offsetBytes : rowBytes - offsetBytes;
+  const size_t leftBytes = rowBytes - leftStart;
+
+  bool oldSwapBytes = tft->getSwapBytes();
+  tft->setSwapBytes(false); // Page buffers hold pixels in sprite (panel) byte order
+  tft->startWrite();
+  for (uint16_t y = 0; y < screenHeight; y += PAGE_BLIT_BAND_ROWS) {
+    uint16_t rows = std::min((int)PAGE_BLIT_BAND_ROWS, screenHeight - y);
+    for (uint16_t r = 0; r < rows; r++) {
+      const size_t rowStart = (size_t)(y + r) * rowBytes;
+      uint8_t* dst = _pageBand + r * rowBytes;
+      memcpy(dst, leftPage + rowStart + leftStart, leftBytes);
+      memcpy(dst + leftBytes, rightPage + rowStart, rowBytes - leftBytes);
+    }
+    if (_pageBytesPerPixel == 2) tft->pushImage(0, y, screenWidth, rows, (uint16_t*)_pageBand);
+    else tft->pushImage(0, y, screenWidth, rows, _pageBand, true);
+  }
+  tft->endWrite();
+  tft->setSwapBytes(oldSwapBytes);
+}
+
+/**
+ * @brief Composes one fade frame by blending the two page buffers band by band.
+ *        Two pixels are blended per 32-bit operation (see RGB565Blend.h).
+ * @param alpha Blend factor 0..RGB565_BLEND_MAX (0: outgoing page, 32: incoming page).
+ */
+void MenuSystem::composeFadeFrame(uint8_t alpha) {
+  const uint16_t* outPixels = (const uint16_t*)_pageOut->getPointer();
+  const uint16_t* inPixels = (const uint16_t*)_pageIn->getPointer();
+
+  bool oldSwapBytes = tft->getSwapBytes();
+  tft->setSwapBytes(false); // Page buffers hold pixels in sprite (panel) byte order
+  tft->startWrite();
+  for (uint16_t y = 0; y < screenHeight; y += PAGE_BLIT_BAND_ROWS) {
+    uint16_t rows = std::min((int)PAGE_BLIT_BAND_ROWS, screenHeight - y);
+    size_t start = (size_t)y * screenWidth;
+    rgb565BlendRow((uint16_t*)_pageBand, outPixels + start, inPixels + start, (size_t)screenWidth * rows, alpha, true);
+    tft->pushImage(0, y, screenWidth, rows, (uint16_t*)_pageBand);
+  }
+  tft->endWrite();
+  tft->setSwapBytes(oldSwapBytes);
+}
+
+/**
+ * @brief Renders the current menu state into a page buffer using the normal drawing routines.
+ * @param page The sprite to render into.
+ */
+void MenuSystem::renderPage(TFT_eSprite* page) {
+  TFT_eSPI* screen = tft;
+  tft = page;          // All drawing routines target the sprite while rendering
+  needFullRedraw = true;
+  drawMenu(true);
+  tft = screen;
+}
+
+/**
+ * @brief Allocates both page buffers and the blit band buffer.
+ *        Uses 16-bit pages when memory allows, otherwise 8-bit (RGB332) pages if allowed.
+ * @param allowRGB332 True to fall back to 8-bit pages when 16-bit pages do not fit.
+ * @return True if all buffers were allocated.
+ */
+bool MenuSystem::allocatePageBuffers(bool allowRGB332) {
+  if (_pageOut != NULL) return true;
+
+  const uint8_t depths[2] = {16, 8};
+  for (uint8_t i = 0; i < (allowRGB332 ? 2 : 1); i++) {
+    _pageOut = new TFT_eSprite(tft);
+    _pageIn = new TFT_eSprite(tft);
+    _pageOut->setColorDepth(depths[i]);
+    _pageIn->setColorDepth(depths[i]);
+    _pageBytesPerPixel = depths[i] / 8;
+    _pageBand = (uint8_t*)malloc((size_t)screenWidth * PAGE_BLIT_BAND_ROWS * _pageBytesPerPixel);
+    if (_pageBand != NULL &&
+        _pageOut->createSprite(screenWidth, screenHeight) != NULL &&
+        _pageIn->createSprite(screenWidth, screenHeight) != NULL) {
+      return true;
+    }
+    releasePageBuffers();
+  }
+  return false;
+}
+
+/**
+ * @brief Frees the page buffers and the blit band buffer.
+ */
+void MenuSystem::releasePageBuffers() {
+  if (_pageOut != NULL) { _pageOut->deleteSprite(); delete _pageOut; _pageOut = NULL; }
+  if (_pageIn != NULL) { _pageIn->deleteSprite(); delete _pageIn; _pageIn = NULL; }
+  if (_pageBand != NULL) { free(_pageBand); _pageBand = NULL; }
+  _pageBytesPerPixel = 0;
+}
+
 //------------------------------------Style Setters------------------------------------//
 void MenuSystem::setBackgroundColor(uint16_t color) {
   backgroundColor = color;
@@ -1136,6 +1553,42 @@ void MenuSystem::setSliderAnimationInterval(uint16_t interval) {
   animInterval = interval;
 }
 
+/**
+ * @brief Sets the transition used when entering a submenu or going back.
+ * @param transition PAGE_TRANSITION_NONE for a plain redraw, PAGE_TRANSITION_SLIDE for a horizontal slide,
+ *        PAGE_TRANSITION_FADE for a cross-fade (also used for the popup window).
+ */
+void MenuSystem::setPageTransition(PageTransition transition) {
+  _pageTransition = transition;
+}
+
+/**
+ * @brief Configures encoder acceleration for navigate().
+ * @param maxStep Maximum number of items moved per detent, 1 disables acceleration.
+ * @param threshold Rotation speed in detents per second above which acceleration starts.
+ */
+void MenuSystem::setNavigationAcceleration(uint8_t maxStep, uint16_t threshold) {
+  _navAccelMaxStep = std::max((uint8_t)1, maxStep);
+  _navAccelThreshold = std::max((uint16_t)1, threshold);
+}
+
+/**
+ * @brief Enables or disables adaptive rendering quality.
+ * @param enable True to enable adaptive quality, false to always render at full quality.
+ */
+void MenuSystem::setAdaptiveQuality(bool enable) {
+  _adaptiveQuality = enable;
+  if (!enable) _renderQuality = RENDER_QUALITY_FULL;
+}
+
+/**
+ * @brief Sets the frame budget used by adaptive rendering quality.
+ * @param budget Frame budget in ms, 0 to use the slider animation interval.
+ */
+void MenuSystem::setFrameBudget(uint16_t budget) {
+  _frameBudget = budget;
+}
+
 /**
  * @brief Calculates the slider's target rectangle based on the current display mode and selected index.
  * @param index The index of the menu item for which to calculate the target rectangle.
@@ -1185,4 +1638,12 @@ uint8_t MenuSystem::getCurrentLevel() {
  */
 uint8_t MenuSystem::getSelectedIndex() {
   return selectedIndex;
+}
+
+/**
+ * @brief Gets the rendering quality currently used for animation frames.
+ * @return The current RenderQuality level.
+ */
+RenderQuality MenuSystem::getRenderQuality() {
+  return _renderQuality;
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <Arduino.h>
 #include <TFT_eSPI.h> // Ensure TFT_eSPI library is installed and configured
 #include "Buzzer.h"   // Ensure you have defined the Buzzer class
+#include "InputQueue.h"
 
 /**
  * @brief Structure to store rectangle information for menu items.
@@ -41,6 +42,48 @@ enum SliderDisplayMode {
   SLIDER_DISPLAY_FIXED_TOP         // Selected item is forced to the top of the menu area; slider is fixed.
 };
 
+/**
+ * @brief Enum defining the transition used when entering a submenu or going back.
+ */
+enum PageTransition {
+  PAGE_TRANSITION_NONE,  // Plain full redraw; only the title decorator animates.
+  PAGE_TRANSITION_SLIDE, // Outgoing and incoming pages slide horizontally.
+  PAGE_TRANSITION_FADE   // Outgoing page cross-fades into the incoming page; also used for the popup window.
+};
+
+#define PAGE_BLIT_BAND_ROWS 8 // Rows composed and pushed per block during page transitions
+
+#define MENU_INPUT_QUEUE_SIZE 32 // Input events buffered between postInput() and update() (power of two)
+
+/**
+ * @brief Enum defining the input events accepted by MenuSystem::postInput().
+ */
+enum MenuInputType : uint8_t {
+  MENU_INPUT_NAVIGATE, // Move the selection; value is the signed number of encoder detents.
+  MENU_INPUT_SELECT,   // Same as select().
+  MENU_INPUT_BACK      // Same as back().
+};
+
+/**
+ * @brief Compact input event passed from input capture (ISR or input task) to the menu.
+ */
+struct MenuInputEvent {
+  uint32_t timestamp; // Time of the input in ms
+  int16_t value;      // Event argument (detents for MENU_INPUT_NAVIGATE)
+  MenuInputType type;
+};
+
+/**
+ * @brief Enum defining the rendering quality levels used for animation frames.
+ *        Each level drops one more drawing step than the previous one.
+ */
+enum RenderQuality {
+  RENDER_QUALITY_FULL,       // Rounded slider/window with border and text.
+  RENDER_QUALITY_PLAIN_RECT, // Plain rectangles instead of rounded ones.
+  RENDER_QUALITY_NO_BORDER,  // Plain rectangles, border skipped.
+  RENDER_QUALITY_NO_TEXT     // Plain rectangles, no border, selected item content skipped until settle.
+};
+
 //------------------------------------MenuItem Class------------------------------------//
 /**
  * @brief Represents a single item within the menu system.
@@ -122,7 +165,7 @@ public:
   uint16_t screenHeight;
   
   /**
-   * @brief Initializes the buzzer.
+   * @brief Initializes the buzzer in asynchronous mode; update() then drives Buzzer::service().
    */
   void buzzer_begin();
 
@@ -136,14 +179,24 @@ public:
 
   /**
    * @brief Moves the selection to the next menu item.
+   *        The step is queued and coalesced with other steps at the next update().
    */
   void selectNext();
 
   /**
    * @brief Moves the selection to the previous menu item.
+   *        The step is queued and coalesced with other steps at the next update().
    */
   void selectPrev();
 
+  /**
+   * @brief Moves the selection by an encoder step delta, with velocity-based acceleration.
+   *        Fast rotation jumps several items per detent; each jump is applied as one animation/redraw.
+   * @param steps Signed number of detents since the last call (positive moves to the next items).
+   * @param timestamp Time of the steps in ms (e.g. millis()).
+   */
+  void navigate(int16_t steps, unsigned long timestamp);
+
   /**
    * @brief Confirms the selection of the current menu item, executing its callback or entering its submenu.
    */
@@ -154,8 +207,44 @@ public:
    */
   void back();
 
+  /**
+   * @brief Posts an input event to be applied at the start of the next update().
+   *        Lock-free and safe to call from an ISR or from a single input task other than the one calling update().
+   *        Only one context may post events. Navigation steps are never lost: when the queue is full they are
+   *        accumulated and queued as one navigation event as soon as there is space, ahead of any later event.
+   * @param type The input event type.
+   * @param value Event argument (signed detents for MENU_INPUT_NAVIGATE).
+   * @param timestamp Time of the input in ms (e.g. millis()).
+   * @return False if a select/back event was dropped because the queue is full.
+   */
+  bool postInput(MenuInputType type, int16_t value, unsigned long timestamp);
+
+  /**
+   * @brief Checks whether update() has nothing to do until new input arrives:
+   *        no running animation or page transition, no pending redraw, no queued input and no buzzer activity.
+   * @return True if the menu is idle.
+   */
+  bool isIdle();
+
+  /**
+   * @brief Blocks the calling task while the menu is idle, until input is posted, wake() is called or maxMs elapses.
+   *        Returns immediately if the menu is not idle. Typical loop: menu.update(); menu.waitForActivity(1000);
+   *        On ESP32 this waits on a FreeRTOS task notification, so the idle task (and automatic light sleep, if
+   *        enabled in the power-management config) gets the CPU. Other platforms return immediately.
+   * @param maxMs Maximum time to wait in ms.
+   * @return True if woken by input, false on timeout or if the menu was not idle.
+   */
+  bool waitForActivity(uint32_t maxMs);
+
+  /**
+   * @brief Wakes a task blocked in waitForActivity(). Safe to call from an ISR or any task;
+   *        postInput() calls it automatically.
+   */
+  static void wake();
+
   /**
    * @brief Updates the menu display, including animations.
+   *        Posted input events are applied in order at the start of each call.
    *        This function should be called frequently in the main loop.
    */
   void update();
@@ -212,7 +301,38 @@ public:
    * @param interval Animation update interval in ms.
    */
   void setSliderAnimationInterval(uint16_t interval);
- 
+
+  /**
+   * @brief Sets the transition used when entering a submenu or going back.
+   *        Page transitions need two full-screen off-screen page buffers (16-bit, or 8-bit for sliding when memory is short);
+   *        if they cannot be allocated the plain redraw is used.
+   *        PAGE_TRANSITION_FADE needs two 16-bit buffers (about 150 KB each at 240x320), which in practice requires PSRAM.
+   *        Without it, menus slide with 8-bit buffers instead and the popup window keeps its grow/shrink animation.
+   * @param transition PAGE_TRANSITION_NONE, PAGE_TRANSITION_SLIDE or PAGE_TRANSITION_FADE.
+   */
+  void setPageTransition(PageTransition transition);
+
+  /**
+   * @brief Configures encoder acceleration for navigate().
+   * @param maxStep Maximum number of items moved per detent, 1 disables acceleration.
+   * @param threshold Rotation speed in detents per second above which acceleration starts.
+   */
+  void setNavigationAcceleration(uint8_t maxStep, uint16_t threshold = 8);
+
+  /**
+   * @brief Enables or disables adaptive rendering quality.
+   *        When enabled, an animation frame that overruns the frame budget lowers the quality
+   *        for the rest of that animation. Full quality is restored on the settled frame.
+   * @param enable True to enable adaptive quality, false to always render at full quality.
+   */
+  void setAdaptiveQuality(bool enable);
+
+  /**
+   * @brief Sets the frame budget used by adaptive rendering quality.
+   * @param budget Frame budget in ms, 0 to use the slider animation interval.
+   */
+  void setFrameBudget(uint16_t budget);
+
   // Get Current State
   /**
    * @brief Gets the current menu level.
@@ -226,6 +346,12 @@ public:
    */
   uint8_t getSelectedIndex();
 
+  /**
+   * @brief Gets the rendering quality currently used for animation frames.
+   * @return The current RenderQuality level.
+   */
+  RenderQuality getRenderQuality();
+
 private:
   TFT_eSPI* tft;
   Buzzer* buzzer;
@@ -236,6 +362,19 @@ private:
   uint8_t selectedIndex;      // Index of the currently selected item
   uint8_t startIndex;         // Starting index of visible menu items (for scrolling)
   uint8_t menuLevel;          // Current menu depth
+  int16_t pendingSelectDelta; // Net selection steps queued since the last frame
+
+  // Input events posted by postInput(), drained at the start of update()
+  InputQueue<MenuInputEvent, MENU_INPUT_QUEUE_SIZE> inputQueue;
+  volatile int32_t inputOverflowSteps; // Navigation steps that did not fit in the queue
+  static void* volatile _waitingTask;  // Task blocked in waitForActivity() (TaskHandle_t), NULL if none
+
+  // Navigation Acceleration (navigate)
+  uint8_t _navAccelMaxStep;       // Max items per detent
+  float _navAccelThreshold;       // Detents per second before acceleration starts
+  float _navVelocity;             // Smoothed rotation speed (detents per second)
+  unsigned long _navLastTime;     // Timestamp of the last navigate() call
+  int8_t _navLastDirection;       // Direction of the last navigate() call
 
   // Menu history, used for navigating back to parent menus
   MenuItem* menuHistory[10];
@@ -298,12 +437,29 @@ private:
   bool type = false;         // Flag to determine if it's a window animation or item animation
   bool BanOperation = false; // Flag to ban user operations during specific animations/states
 
+  // Adaptive Rendering Quality
+  bool _adaptiveQuality;         // Flag to lower quality when a frame overruns the budget
+  uint16_t _frameBudget;         // Frame budget (ms), 0 uses animInterval
+  RenderQuality _renderQuality;  // Quality used for the current animation frames
+
   // Title Decorator Animation Parameters
   AnimationState titleDecoratorAnim; // Title decorator animation state
   bool titleDecoratorAnimationActive; // Flag indicating if title decorator animation is active
   unsigned long lastTitleDecoratorAnimTime; // Last title decorator animation update time
   int currentTitleDecoratorX; // Current X coordinate for drawing the title decorator
 
+  // Page Transition Parameters
+  PageTransition _pageTransition;    // Transition used for submenu enter/back
+  PageTransition activePageTransition; // Transition currently running
+  bool pageTransitionActive;         // Flag indicating if a page transition is running
+  int8_t pageTransitionDirection;    // 1: entering a submenu, -1: going back, 0: popup window
+  AnimationState pageTransitionAnim; // Transition progress (x: horizontal offset in pixels)
+  unsigned long lastPageTransitionTime; // Last page transition update time
+  TFT_eSprite* _pageOut;             // Off-screen copy of the outgoing page
+  TFT_eSprite* _pageIn;              // Off-screen copy of the incoming page
+  uint8_t* _pageBand;                // Band buffer composed from both pages and pushed per block
+  uint8_t _pageBytesPerPixel;        // Page buffer pixel size (2: RGB565, 1: RGB332)
+
   // Anti-Flicker Optimization
   int8_t lastSelectedIndex;
   int8_t lastStartIndex;
@@ -378,6 +534,80 @@ private:
    */
   void updateTitleDecoratorAnimation();
 
+  /**
+   * @brief Applies all queued selection steps as one net delta: one beep, one slider retarget
+   *        and at most one scroll redraw per frame.
+   */
+  void applyPendingSelection();
+
+  /**
+   * @brief Queues a selection delta, coalesced with other queued steps in applyPendingSelection.
+   * @param delta Signed number of items to move.
+   */
+  void queueSelectDelta(int16_t delta);
+
+  /**
+   * @brief Applies the events posted by postInput() in order.
+   *        Select/back events stay queued while a page transition is running.
+   */
+  void drainInput();
+
+  /**
+   * @brief Queues the navigation steps that overflowed the input queue as one navigation event.
+   * @param timestamp Time stamped on the navigation event.
+   * @return True if no overflowed steps remain.
+   */
+  bool flushInputOverflow(uint32_t timestamp);
+
+  // Page transition related
+  /**
+   * @brief Allocates the page buffers and renders the outgoing page. Call before the menu state changes.
+   * @param popup True for the popup window path, which only supports the fade transition.
+   * @return True if a page transition can be run, false to fall back to a plain redraw.
+   */
+  bool beginPageTransition(bool popup = false);
+
+  /**
+   * @brief Renders the incoming page and starts the transition. Call after the menu state has changed.
+   * @param direction 1 when entering a submenu, -1 when going back, 0 for the popup window.
+   */
+  void startPageTransition(int8_t direction);
+
+  /**
+   * @brief Advances the page transition and composes one frame.
+   */
+  void updatePageTransition();
+
+  /**
+   * @brief Composes one transition frame by offset blits of the two page buffers.
+   * @param offset Horizontal offset in pixels (0: outgoing page, screenWidth: incoming page).
+   */
+  void composePageFrame(int offset);
+
+  /**
+   * @brief Composes one fade frame by blending the two page buffers.
+   * @param alpha Blend factor 0..32 (0: outgoing page, 32: incoming page).
+   */
+  void composeFadeFrame(uint8_t alpha);
+
+  /**
+   * @brief Renders the current menu state into a page buffer using the normal drawing routines.
+   * @param page The sprite to render into.
+   */
+  void renderPage(TFT_eSprite* page);
+
+  /**
+   * @brief Allocates both page buffers and the blit band buffer.
+   * @param allowRGB332 True to fall back to 8-bit pages when 16-bit pages do not fit.
+   * @return True if all buffers were allocated.
+   */
+  bool allocatePageBuffers(bool allowRGB332);
+
+  /**
+   * @brief Frees the page buffers and the blit band buffer.
+   */
+  void releasePageBuffers();
+
   // Drawing related
   /**
    * @brief Draws the menu title.
@@ -410,6 +640,15 @@ private:
    */
   void drawAnimatedWindow();
 
+  /**
+   * @brief Draws the highlight background and border of the slider or window at the current render quality.
+   * @param x X coordinate.
+   * @param y Y coordinate.
+   * @param width Width of the area.
+   * @param height Height of the area.
+   */
+  void drawAnimatedFrame(int x, int y, int width, int height);
+
   /**
    * @brief Draws the scrollbar if the menu items exceed the visible display area.
    */
@@ -1,7 +1,7 @@
 #include <TFT_eSPI.h>
 #include <TFT_Menu.h>
-#include <ESP32Encoder.h>
 #include <KeyLib.h>
+#include <RotaryEncoder.h>
 #include <Buzzer.h>
 #include <Arduino.h>
 #include <esp32-hal.h>
@@ -16,12 +16,16 @@ bool lastButtonState = HIGH;
 
 //--------------------------declar---------------------------
 
-ESP32Encoder encoder;
+RotaryEncoder encoder(14, 36);  // CLK=GPIO14, DT=GPIO36
 TFT_eSPI tft = TFT_eSPI();
 KeyLib keyLib(50);
 Buzzer buzzer(BUZZ_PIN,BUZZ_VPIN); // Buzzer pin
 MenuSystem menu(&tft,&buzzer); // 菜单对象
 
+TaskHandle_t inputTaskHandle = NULL; // 输入任务，空闲时阻塞等待按键/编码器中断
+
+void InputTask(void* arg);
+void WakeInputTask();
 void AnimationCallback(uint8_t animationType);
 void BuzzCallback();
 void DelayCallBack();
@@ -71,11 +75,18 @@ void setup() {
   // 初始化TFT显示屏
   tft.init();
   tft.setRotation(2);	
-  // 初始化编码器
-  encoder.attachSingleEdge(14, 36);  // 使用 CLK=GPIO18, DT=GPIO16
-  encoder.setCount(0);  // 初始计数值设为 0
+  // 初始化编码器：PCNT硬件计数，每转过一档直接驱动菜单导航(按转速加速)
+  encoder.onRotate([](int16_t delta, unsigned long timestamp) { menu.postInput(MENU_INPUT_NAVIGATE, delta, timestamp); });
+  encoder.onActivity(WakeInputTask);  // 编码器转动时唤醒输入任务
+  encoder.begin();
+  keyLib.addSource(&encoder);  // 由keyLib.update()读取编码器
 
   pinMode(BTN_SELECT, INPUT_PULLUP);  // 设置摁钮引脚为输入模式
+  keyLib.setInterruptMode(true);  // 按键边沿由中断记录，主循环卡顿时也不会漏掉按键
+  keyLib.registerKey(BTN_SELECT);
+  keyLib.setGestureTiming(700);  // 长按700ms返回，不识别双击，松开即为单击
+  keyLib.setWakeCallback(WakeInputTask);  // 按键边沿唤醒输入任务
+  menu.buzzer_begin(); // 初始化蜂鸣器(异步模式，提示音不阻塞界面)
   // 配置菜单外观
   menu.setBackgroundColor(TFT_BLACK);
   menu.setMenuBgColor(TFT_BLACK);
@@ -98,45 +109,51 @@ void setup() {
   // 设置根菜单
   menu.setRootMenu(main_menu_items, 2);
   menu.setSliderDisplayMode(SLIDER_DISPLAY_FOLLOW_SELECTION);
+  menu.setPageTransition(PAGE_TRANSITION_SLIDE); // 进入/返回子菜单时页面横向滑动
 
   
   // 初始显示菜单
   menu.drawMenu(0);
-}
-
-void loop() {
 
-    // 菜单模式
-    static long lastCount = 0;
-    long currentCount = encoder.getCount();
+  // 输入采集放在独立任务中，通过无锁队列交给菜单，绘制耗时不影响按键和编码器的响应
+  xTaskCreatePinnedToCore(InputTask, "input", 4096, NULL, 2, &inputTaskHandle, 1);
+}
 
-    if (currentCount > lastCount) {
-      // 编码器向前旋转
-      menu.selectNext();
-      lastCount = currentCount;
-      delay(70);  // 防抖 
-    }
+void IRAM_ATTR WakeInputTask() {
+  if (inputTaskHandle == NULL) return;
+  if (xPortInIsrContext()) {
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(inputTaskHandle, &woken);
+    if (woken) portYIELD_FROM_ISR();
+  } else {
+    xTaskNotifyGive(inputTaskHandle);
+  }
+}
 
-    if (currentCount < lastCount) {
-      // 编码器向后旋转
-      menu.selectPrev();
-      lastCount = currentCount;
-      delay(70);  // 防抖
+void InputTask(void* arg) {
+  for (;;) {
+    // 读取编码器和按钮：每个按键每次只采样一次，手势按发生顺序从事件队列取出
+    keyLib.update();
+    KeyEvent event;
+    while (keyLib.getEvent(event)) {
+      if (event.type == KEY_EVENT_CLICK) {
+        menu.postInput(MENU_INPUT_SELECT, 0, event.time);
+      } else if (event.type == KEY_EVENT_LONG_PRESS) {
+        menu.postInput(MENU_INPUT_BACK, 0, event.time);
+      }
     }
+    // 没有待处理的计时(消抖、长按、重复)时一直阻塞，直到按键或编码器中断唤醒
+    unsigned long wait = keyLib.nextDeadline();
+    ulTaskNotifyTake(pdTRUE, wait == KEYLIB_NO_DEADLINE ? portMAX_DELAY : pdMS_TO_TICKS(wait));
+  }
+}
 
-    // 处理按钮输入
-    if (keyLib.singlePress(BTN_SELECT)) {
-      menu.select();
-      delay(200);  // 防抖
-    }
+void loop() {
 
-    if (keyLib.longPress(BTN_SELECT, 700)) {
-      menu.back();
-      delay(200);  // 防抖     
-    }
-    
-    // 更新菜单动画
+    // 应用输入任务送来的输入，更新菜单动画
     menu.update();
+    // 没有动画、重绘和输入时阻塞，直到输入任务送来输入
+    menu.waitForActivity(1000);
 }
 
 
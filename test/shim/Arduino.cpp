@@ -0,0 +1,36 @@
+#include "Arduino.h"
+#include <chrono>
+#include <thread>
+
+Print Serial;
+
+static uint8_t pinLevels[SHIM_PIN_COUNT];
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin >= SHIM_PIN_COUNT) return;
+  if (mode == INPUT_PULLUP) pinLevels[pin] = HIGH;
+  else if (mode == INPUT_PULLDOWN) pinLevels[pin] = LOW;
+}
+
+int digitalRead(uint8_t pin) {
+  return pin < SHIM_PIN_COUNT ? pinLevels[pin] : LOW;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  if (pin < SHIM_PIN_COUNT) pinLevels[pin] = value ? HIGH : LOW;
+}
+
+static std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+unsigned long micros() {
+  return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - startTime).count();
+}
+
+unsigned long millis() {
+  return micros() / 1000;
+}
+
+void delay(unsigned long ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
@@ -0,0 +1,50 @@
+/**
+ * Minimal Arduino shim for host tests.
+ * Only covers what the libraries under test use; pins read back what the test writes
+ * and the clock is the host's steady clock.
+ */
+
+#ifndef ARDUINO_SHIM_H
+#define ARDUINO_SHIM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HIGH 1
+#define LOW 0
+
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define INPUT_PULLDOWN 0x09
+
+#define CHANGE 0x03
+
+#define IRAM_ATTR
+
+#define SHIM_PIN_COUNT 64
+
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t value);
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+
+/**
+ * @brief Text output, printed to stdout.
+ */
+class Print {
+  public:
+    virtual ~Print() {}
+    virtual void print(const char* text) { fputs(text, stdout); }
+    void println(const char* text = "") { print(text); print("\n"); }
+};
+
+extern Print Serial;
+
+#endif
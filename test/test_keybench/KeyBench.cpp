@@ -0,0 +1,310 @@
+#include "KeyBench.h"
+#include <stdio.h>
+
+#define BENCH_LEAD_US 100000UL      // 每次试验开始前的空闲时间(微秒)
+#define BENCH_TAIL_MS 200           // 最后一次松开后继续运行的时间(毫秒，另加双击间隔和消抖时间)
+#define BENCH_LONG_EXTRA_MS 300     // 长按试验中超过长按时间后继续按住的时间(毫秒)
+#define BENCH_IDLE_US 1000000UL     // 空闲试验的时长(微秒)
+#define BENCH_BAR_WIDTH 40          // 直方图条的最大宽度(字符)
+
+// 随机数(xorshift32)，返回[0, range)
+static uint32_t nextRandom(uint32_t &state, uint32_t range) {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return range > 0 ? state % range : 0;
+}
+
+BounceWaveform::BounceWaveform(const BounceProfile &profile, uint32_t seed) {
+  this->profile = profile;
+  rng = seed != 0 ? seed : 1;
+  clear();
+}
+
+void BounceWaveform::clear() {
+  count = 0;
+  cursor = 0;
+  stableFrom = 0;
+}
+
+bool BounceWaveform::addEdge(uint32_t timeUs) {
+  if (count >= BENCH_MAX_EDGES) return false;
+  edges[count++] = timeUs;
+  return true;
+}
+
+bool BounceWaveform::transition(uint32_t timeUs, uint32_t &settledUs) {
+  if (!addEdge(timeUs)) return false;
+  settledUs = timeUs;
+  if (profile.bounceCount == 0) return true;
+
+  long duration = profile.bounceDuration;
+  if (profile.jitter > 0) {
+    duration += (long)nextRandom(rng, 2 * profile.jitter + 1) - profile.jitter;
+  }
+  uint32_t flips = 2 * profile.bounceCount;
+  if (duration < (long)flips) duration = flips;
+
+  // 分层随机：第k次翻转落在持续时间的第k段内，时间保证递增
+  for (uint32_t k = 0; k < flips; k++) {
+    uint32_t t = timeUs + ((k * 1000 + nextRandom(rng, 1000)) * (uint32_t)duration) / (flips * 1000);
+    if (t <= edges[count - 1]) t = edges[count - 1] + 1;
+    if (!addEdge(t)) return false;
+    settledUs = t;
+  }
+  return true;
+}
+
+bool BounceWaveform::addGlitches(uint32_t fromUs, uint32_t toUs) {
+  if (profile.glitchRate == 0 || profile.glitchWidth == 0) return true;
+  // 毛刺间隔在[0, 2倍平均间隔)内均匀分布
+  uint32_t meanGap = 1000000UL / profile.glitchRate;
+  uint32_t t = fromUs + 1 + nextRandom(rng, 2 * meanGap);
+  while (t + profile.glitchWidth < toUs) {
+    if (!addEdge(t) || !addEdge(t + profile.glitchWidth)) return false;
+    t += profile.glitchWidth + 1 + nextRandom(rng, 2 * meanGap);
+  }
+  return true;
+}
+
+bool BounceWaveform::press(uint32_t startUs, uint32_t holdUs) {
+  if (startUs <= stableFrom && count > 0) startUs = stableFrom + 1;
+  if (!addGlitches(stableFrom, startUs)) return false;
+  uint32_t settled;
+  if (!transition(startUs, settled)) return false;
+  uint32_t releaseUs = startUs + holdUs;
+  if (releaseUs <= settled) releaseUs = settled + 1;
+  if (!addGlitches(settled, releaseUs)) return false;
+  return transition(releaseUs, stableFrom);
+}
+
+bool BounceWaveform::extend(uint32_t untilUs) {
+  if (!addGlitches(stableFrom, untilUs)) return false;
+  if (untilUs > stableFrom) stableFrom = untilUs;
+  return true;
+}
+
+bool BounceWaveform::level(uint32_t timeUs) {
+  if (cursor > 0 && edges[cursor - 1] > timeUs) cursor = 0;
+  while (cursor < count && edges[cursor] <= timeUs) cursor++;
+  // 从松开开始，奇数次翻转后为按下
+  return cursor & 1;
+}
+
+uint32_t BounceWaveform::endUs() {
+  return count > 0 ? edges[count - 1] : 0;
+}
+
+uint16_t BounceWaveform::edgeCount() {
+  return count;
+}
+
+BounceWaveform* KeyBench::wave = NULL;
+uint32_t KeyBench::clockUs = 0;
+uint8_t KeyBench::pin = 0;
+uint32_t KeyBench::rng = 1;
+
+int KeyBench::readHook(uint8_t pin) {
+  // 模拟的按键为低电平有效
+  if (pin != KeyBench::pin || wave == NULL) return HIGH;
+  return wave->level(clockUs) ? LOW : HIGH;
+}
+
+unsigned long KeyBench::millisHook() {
+  return clockUs / 1000;
+}
+
+unsigned long KeyBench::microsHook() {
+  return clockUs;
+}
+
+// 名义时间随机±25%，返回微秒
+static uint32_t vary(uint32_t &rng, uint16_t ms) {
+  return (uint32_t)ms * 1000 / 100 * (75 + nextRandom(rng, 51));
+}
+
+void KeyBench::run(const KeyBenchConfig &config, KeyBenchResult* results) {
+  memset(results, 0, sizeof(KeyBenchResult) * BENCH_GESTURE_COUNT);
+  for (int g = 0; g < BENCH_GESTURE_COUNT; g++) {
+    results[g].latency.min = 0xFFFF;
+  }
+
+  BounceWaveform waveform(config.bounce, config.seed);
+  rng = config.seed * 2654435761UL + 1;
+  if (rng == 0) rng = 1;
+  pin = config.pin;
+  wave = &waveform;
+  for (uint16_t i = 0; i < config.trials; i++) {
+    for (int g = 0; g < BENCH_GESTURE_COUNT; g++) {
+      if (g == BENCH_DOUBLE_CLICK && config.doubleClickTime == 0) continue;
+      runTrial(config, (KeyBenchGesture)g, waveform, results[g]);
+    }
+  }
+  wave = NULL;
+}
+
+void KeyBench::runTrial(const KeyBenchConfig &config, KeyBenchGesture gesture, BounceWaveform &waveform, KeyBenchResult &result) {
+  // 生成波形，记录理想的识别时间点
+  waveform.clear();
+  uint32_t start = BENCH_LEAD_US + nextRandom(rng, 1000);  // 与update()的相位随机
+  uint32_t idealUs = 0;
+  uint8_t expected = KEY_EVENT_NONE;
+  uint8_t expectedPresses = 1;
+  switch (gesture) {
+    case BENCH_IDLE:
+      expectedPresses = 0;
+      waveform.extend(start + BENCH_IDLE_US);
+      break;
+    case BENCH_CLICK: {
+      uint32_t hold = vary(rng, config.clickHold);
+      waveform.press(start, hold);
+      idealUs = start + hold;
+      expected = KEY_EVENT_CLICK;
+      break;
+    }
+    case BENCH_DOUBLE_CLICK: {
+      uint32_t hold = vary(rng, config.clickHold);
+      uint32_t second = start + hold + vary(rng, config.clickGap);
+      uint32_t hold2 = vary(rng, config.clickHold);
+      waveform.press(start, hold);
+      waveform.press(second, hold2);
+      idealUs = second + hold2;
+      expected = KEY_EVENT_DOUBLE_CLICK;
+      expectedPresses = 2;
+      break;
+    }
+    default: {
+      waveform.press(start, ((uint32_t)config.longPressTime + BENCH_LONG_EXTRA_MS) * 1000);
+      idealUs = start + (uint32_t)config.longPressTime * 1000;
+      expected = KEY_EVENT_LONG_PRESS;
+      break;
+    }
+  }
+  uint32_t endUs = waveform.endUs() + ((uint32_t)config.doubleClickTime + config.debounce + BENCH_TAIL_MS) * 1000;
+  waveform.extend(endUs);
+  if (waveform.edgeCount() > result.maxEdges) result.maxEdges = waveform.edgeCount();
+
+  KeyLib keys(config.debounce);
+  keys.setHooks(readHook, millisHook, microsHook);
+  keys.setGestureTiming(config.longPressTime, config.doubleClickTime);
+  keys.setScanMode(config.scanMode);
+  KeyConfig keyConfig = {LOW, KEY_PULL_NONE, 0};
+
+  // 以虚拟时间按固定间隔调用update()，事件的检测时间为取出事件时的时钟
+  uint32_t step = (config.updateInterval > 0 ? config.updateInterval : 1) * 1000UL;
+  uint16_t presses = 0;
+  bool detected = false;
+  bool other = false;
+  long latencyMs = 0;
+  clockUs = 0;
+  keys.registerKey(pin, keyConfig);
+  for (; clockUs <= endUs; clockUs += step) {
+    keys.update();
+    KeyEvent event;
+    while (keys.getEvent(event)) {
+      if (event.type == KEY_EVENT_PRESS) {
+        presses++;
+      } else if (event.type == expected && !detected) {
+        detected = true;
+        latencyMs = (long)(clockUs / 1000) - (long)(idealUs / 1000);
+      } else if (event.type == KEY_EVENT_CLICK || event.type == KEY_EVENT_DOUBLE_CLICK || event.type == KEY_EVENT_LONG_PRESS) {
+        other = true;
+      }
+    }
+  }
+
+  result.trials++;
+  if (presses > expectedPresses) result.falsePositives += presses - expectedPresses;
+  if (gesture == BENCH_IDLE) return;
+  if (detected) {
+    result.detected++;
+  } else if (other) {
+    result.wrong++;
+  } else {
+    result.missed++;
+  }
+  if (!detected) return;
+
+  KeyBenchLatency &latency = result.latency;
+  uint16_t ms = latencyMs > 0 ? (latencyMs < 0xFFFF ? latencyMs : 0xFFFF) : 0;
+  uint16_t bucket = ms / BENCH_LATENCY_BUCKET_MS;
+  latency.histogram[bucket < BENCH_LATENCY_BUCKETS ? bucket : BENCH_LATENCY_BUCKETS - 1]++;
+  latency.count++;
+  latency.total += ms;
+  if (ms < latency.min) latency.min = ms;
+  if (ms > latency.max) latency.max = ms;
+}
+
+uint16_t KeyBench::percentile(const KeyBenchLatency &latency, uint8_t percent) {
+  if (latency.count == 0) return 0;
+  uint32_t target = (latency.count * percent + 99) / 100;
+  uint32_t sum = 0;
+  for (int i = 0; i < BENCH_LATENCY_BUCKETS; i++) {
+    sum += latency.histogram[i];
+    if (sum >= target) {
+      uint16_t upper = (i + 1) * BENCH_LATENCY_BUCKET_MS - 1;
+      return upper < latency.max ? upper : latency.max;
+    }
+  }
+  return latency.max;
+}
+
+void KeyBench::print(const KeyBenchConfig &config, const KeyBenchResult* results, Print &out) {
+  static const char* names[BENCH_GESTURE_COUNT] = {"idle", "click", "double", "long"};
+  char line[96];
+
+  snprintf(line, sizeof(line), "debounce %ums, long %ums, double %ums, update %ums%s\r\n",
+           config.debounce, config.longPressTime, config.doubleClickTime, config.updateInterval, config.scanMode ? ", scan" : "");
+  out.print(line);
+  snprintf(line, sizeof(line), "bounce %u x %uus +-%uus, glitch %u/s x %uus, seed %lu\r\n",
+           config.bounce.bounceCount, config.bounce.bounceDuration, config.bounce.jitter,
+           config.bounce.glitchRate, config.bounce.glitchWidth, (unsigned long)config.seed);
+  out.print(line);
+  out.print("gesture  trials    ok wrong  miss false   min   p50   p90   p99   max  mean\r\n");
+
+  for (int g = 0; g < BENCH_GESTURE_COUNT; g++) {
+    const KeyBenchResult &r = results[g];
+    if (r.trials == 0) continue;
+    const KeyBenchLatency &l = r.latency;
+    if (l.count == 0) {
+      snprintf(line, sizeof(line), "%-8s %6u %5u %5u %5u %5lu\r\n",
+               names[g], r.trials, r.detected, r.wrong, r.missed, (unsigned long)r.falsePositives);
+      out.print(line);
+      continue;
+    }
+    snprintf(line, sizeof(line), "%-8s %6u %5u %5u %5u %5lu %5u %5u %5u %5u %5u %5lu\r\n",
+             names[g], r.trials, r.detected, r.wrong, r.missed, (unsigned long)r.falsePositives,
+             l.min, percentile(l, 50), percentile(l, 90), percentile(l, 99), l.max,
+             (unsigned long)(l.total / l.count));
+    out.print(line);
+  }
+
+  // 每种手势的延迟直方图(毫秒)
+  for (int g = 0; g < BENCH_GESTURE_COUNT; g++) {
+    const KeyBenchLatency &l = results[g].latency;
+    if (l.count == 0) continue;
+    uint16_t peak = 0;
+    for (int i = 0; i < BENCH_LATENCY_BUCKETS; i++) {
+      if (l.histogram[i] > peak) peak = l.histogram[i];
+    }
+    snprintf(line, sizeof(line), "%s latency:\r\n", names[g]);
+    out.print(line);
+    for (int i = 0; i < BENCH_LATENCY_BUCKETS; i++) {
+      if (l.histogram[i] == 0) continue;
+      int n;
+      if (i == BENCH_LATENCY_BUCKETS - 1) {
+        n = snprintf(line, sizeof(line), "  %4u+     %5u ", i * BENCH_LATENCY_BUCKET_MS, l.histogram[i]);
+      } else {
+        n = snprintf(line, sizeof(line), "  %4u-%-4u %5u ", i * BENCH_LATENCY_BUCKET_MS,
+                     (i + 1) * BENCH_LATENCY_BUCKET_MS - 1, l.histogram[i]);
+      }
+      int bar = (uint32_t)l.histogram[i] * BENCH_BAR_WIDTH / peak;
+      if (bar == 0) bar = 1;
+      for (int k = 0; k < bar && n < (int)sizeof(line) - 3; k++) line[n++] = '#';
+      line[n++] = '\r';
+      line[n++] = '\n';
+      line[n] = '\0';
+      out.print(line);
+    }
+  }
+}
\ No newline at end of file
@@ -0,0 +1,133 @@
+#ifndef KEYBENCH_H
+#define KEYBENCH_H
+
+#include <Arduino.h>
+#include "KeyLib.h"
+
+#define BENCH_MAX_EDGES 256         // 一个波形最多的电平翻转数
+#define BENCH_LATENCY_BUCKETS 32    // 延迟直方图的桶数(最后一桶包括更大的值)
+#define BENCH_LATENCY_BUCKET_MS 10  // 延迟直方图每桶的宽度(毫秒)
+
+// 触点抖动参数
+struct BounceProfile {
+  uint8_t bounceCount;      // 每次按下/松开后的抖动次数(每次为一对电平翻转)
+  uint16_t bounceDuration;  // 抖动持续时间(微秒)，抖动随机分布在这段时间内
+  uint16_t jitter;          // 抖动持续时间的随机变化(±微秒)
+  uint16_t glitchRate;      // 稳定期间每秒的噪声毛刺数，0为没有毛刺
+  uint16_t glitchWidth;     // 噪声毛刺宽度(微秒)
+};
+
+// 合成的按键波形：按理想的按下/松开时间加上触点抖动和噪声毛刺，记录为电平翻转时间表
+class BounceWaveform {
+  public:
+    BounceWaveform(const BounceProfile &profile, uint32_t seed = 1);
+
+    // 清空波形(回到松开状态)
+    void clear();
+
+    // 在startUs按下，按住holdUs后松开(时间需在上一次松开之后)，并在这之前的稳定期间加入毛刺
+    // 翻转数超出BENCH_MAX_EDGES时返回false
+    bool press(uint32_t startUs, uint32_t holdUs);
+
+    // 在最后一次松开之后到untilUs之间加入毛刺
+    bool extend(uint32_t untilUs);
+
+    // timeUs时是否为按下电平(按时间递增查询时为O(1))
+    bool level(uint32_t timeUs);
+
+    // 最后一次电平翻转的时间
+    uint32_t endUs();
+
+    // 电平翻转数
+    uint16_t edgeCount();
+
+  private:
+    BounceProfile profile;
+    uint32_t rng;
+    uint32_t edges[BENCH_MAX_EDGES];
+    uint16_t count;
+    uint16_t cursor;                // 上一次查询所在的位置
+    uint32_t stableFrom;            // 最后一次抖动结束的时间
+
+    // 在timeUs产生一次翻转并加入抖动，settledUs为抖动结束的时间
+    bool transition(uint32_t timeUs, uint32_t &settledUs);
+
+    // 在[fromUs, toUs)的稳定期间加入毛刺
+    bool addGlitches(uint32_t fromUs, uint32_t toUs);
+
+    bool addEdge(uint32_t timeUs);
+};
+
+// 测试台要模拟的手势
+enum KeyBenchGesture {
+  BENCH_IDLE = 0,           // 不按键(只有噪声毛刺)，产生的事件都是误报
+  BENCH_CLICK,
+  BENCH_DOUBLE_CLICK,       // 双击间隔为0时不测试
+  BENCH_LONG_PRESS,
+  BENCH_GESTURE_COUNT
+};
+
+// 测试台配置
+struct KeyBenchConfig {
+  uint16_t debounce;        // KeyLib的消抖时间(毫秒)
+  uint16_t longPressTime;   // 长按时间(毫秒)
+  uint16_t doubleClickTime; // 双击间隔(毫秒)，0为关闭双击识别
+  uint16_t clickHold;       // 单击按住的时间(毫秒，每次试验随机±25%)
+  uint16_t clickGap;        // 双击两次按下之间松开的时间(毫秒，每次试验随机±25%)
+  uint8_t updateInterval;   // 调用update()的间隔(毫秒)
+  bool scanMode;            // 使用扫描模式
+  uint8_t pin;              // 模拟的按键引脚(在设备上运行时选择一个未使用的引脚，注册时会配置为输入)
+  uint16_t trials;          // 每种手势的试验次数
+  uint32_t seed;            // 随机数种子，相同的配置和种子产生相同的结果
+  BounceProfile bounce;
+};
+
+// 检测延迟分布：从理想的时间点(单击/双击为最后一次松开，长按为按下后达到长按时间)到update()产生事件
+struct KeyBenchLatency {
+  uint16_t histogram[BENCH_LATENCY_BUCKETS];
+  uint32_t count;
+  uint32_t total;
+  uint16_t min;
+  uint16_t max;
+};
+
+// 一种手势的结果
+struct KeyBenchResult {
+  uint16_t trials;
+  uint16_t detected;        // 识别为正确的手势
+  uint16_t wrong;           // 识别为其他手势
+  uint16_t missed;          // 没有产生手势事件
+  uint32_t falsePositives;  // 多余的按下事件(抖动或毛刺通过了消抖)
+  uint16_t maxEdges;        // 单次试验中最多的电平翻转数
+  KeyBenchLatency latency;
+};
+
+// 按键测试台：用合成的抖动波形和虚拟时间通过KeyLib::setHooks驱动KeyLib，统计识别准确率、误报和检测延迟
+// 每次试验使用一个新的KeyLib，所有时间都是虚拟的，运行速度只取决于CPU
+class KeyBench {
+  public:
+    // 运行所有手势的试验，结果写入results[BENCH_GESTURE_COUNT]
+    static void run(const KeyBenchConfig &config, KeyBenchResult* results);
+
+    // 输出结果(每种手势一行汇总和延迟直方图)
+    static void print(const KeyBenchConfig &config, const KeyBenchResult* results, Print &out);
+
+    // 延迟分布的百分位数(毫秒，按直方图桶的上界)
+    static uint16_t percentile(const KeyBenchLatency &latency, uint8_t percent);
+
+  private:
+    // 运行一次试验
+    static void runTrial(const KeyBenchConfig &config, KeyBenchGesture gesture, BounceWaveform &waveform, KeyBenchResult &result);
+
+    // 替换KeyLib的读引脚和时钟函数
+    static int readHook(uint8_t pin);
+    static unsigned long millisHook();
+    static unsigned long microsHook();
+
+    static BounceWaveform* wave;
+    static uint32_t clockUs;
+    static uint8_t pin;
+    static uint32_t rng;            // 试验时序(按住时间、相位)的随机数
+};
+
+#endif
\ No newline at end of file
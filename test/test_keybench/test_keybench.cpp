@@ -0,0 +1,54 @@
+#include "KeyBench.h"
+
+// 主机上运行KeyBench：每组配置输出结果表，并检查识别结果是否符合预期
+// 用`make -C test`编译运行，有检查失败时返回1
+
+struct BenchCase {
+  const char* name;
+  bool expectClean;         // true：所有手势都应正确识别且没有误报；false：毛刺超过消抖时间，应检测到误报
+  KeyBenchConfig config;
+};
+
+static const BenchCase cases[] = {
+  // 抖动在消抖时间内结束，没有毛刺
+  {"clean contacts", true, {30, 800, 250, 120, 100, 1, false, 4, 300, 12345, {5, 3000, 1500, 0, 0}}},
+  // 抖动比消抖时间长(消抖计时在每次翻转后重新开始)，加上短毛刺
+  {"heavy bounce, short debounce", true, {5, 800, 250, 120, 100, 1, false, 4, 300, 12345, {8, 8000, 4000, 20, 200}}},
+  // 扫描模式
+  {"scan mode", true, {20, 800, 250, 120, 100, 1, true, 4, 300, 12345, {8, 8000, 4000, 20, 200}}},
+  // 关闭双击，update()间隔5ms
+  {"scan mode, no double click", true, {20, 800, 0, 120, 100, 5, true, 4, 300, 12345, {8, 8000, 4000, 20, 200}}},
+  // 毛刺宽度超过消抖时间，测试台必须报告误报
+  {"glitches wider than debounce", false, {5, 800, 250, 120, 100, 1, false, 4, 300, 12345, {8, 8000, 4000, 20, 8000}}},
+};
+
+// 检查一组结果，返回是否符合预期
+static bool check(const BenchCase &benchCase, const KeyBenchResult* results) {
+  uint32_t falsePositives = 0;
+  bool allDetected = true;
+  for (int g = 0; g < BENCH_GESTURE_COUNT; g++) {
+    const KeyBenchResult &r = results[g];
+    falsePositives += r.falsePositives;
+    if (g != BENCH_IDLE && r.detected != r.trials) allDetected = false;
+  }
+  if (benchCase.expectClean) return allDetected && falsePositives == 0;
+  return falsePositives > 0;
+}
+
+int main() {
+  KeyBenchResult results[BENCH_GESTURE_COUNT];
+  int failed = 0;
+  const int caseCount = sizeof(cases) / sizeof(cases[0]);
+
+  for (int i = 0; i < caseCount; i++) {
+    printf("== %s\r\n", cases[i].name);
+    KeyBench::run(cases[i].config, results);
+    KeyBench::print(cases[i].config, results, Serial);
+    bool ok = check(cases[i], results);
+    printf("%s\r\n\r\n", ok ? "PASS" : "FAIL");
+    if (!ok) failed++;
+  }
+
+  printf("%d/%d passed\r\n", caseCount - failed, caseCount);
+  return failed == 0 ? 0 : 1;
+}
\ No newline at end of file
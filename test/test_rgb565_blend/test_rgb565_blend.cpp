@@ -0,0 +1,155 @@
+/**
+ * Host test for the SWAR RGB565 blend kernel (RGB565Blend.h).
+ * Checks rgb565BlendRow() against a per-field scalar reference and compares their speed.
+ * Build and run with `make -C test`.
+ */
+
+#include "RGB565Blend.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+
+#define FRAME_WIDTH 240
+#define FRAME_HEIGHT 320
+#define TIMING_ITERATIONS 200
+
+static uint32_t nowUs() {
+  return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static uint16_t swapBytes(uint16_t x) {
+  return (uint16_t)((x >> 8) | (x << 8));
+}
+
+/**
+ * @brief Scalar reference: blends each colour field separately, truncating like the kernel.
+ */
+static uint16_t referenceBlend(uint16_t from, uint16_t to, uint8_t alpha, bool swapped) {
+  if (swapped) {
+    from = swapBytes(from);
+    to = swapBytes(to);
+  }
+  int inv = RGB565_BLEND_MAX - alpha;
+  int r = ((from >> 11) * inv + (to >> 11) * alpha) >> 5;
+  int g = (((from >> 5) & 0x3F) * inv + ((to >> 5) & 0x3F) * alpha) >> 5;
+  int b = ((from & 0x1F) * inv + (to & 0x1F) * alpha) >> 5;
+  uint16_t out = (uint16_t)((r << 11) | (g << 5) | b);
+  return swapped ? swapBytes(out) : out;
+}
+
+static void referenceBlendRow(uint16_t* dst, const uint16_t* from, const uint16_t* to, size_t count, uint8_t alpha, bool swapped) {
+  for (size_t i = 0; i < count; i++) dst[i] = referenceBlend(from[i], to[i], alpha, swapped);
+}
+
+/**
+ * @brief Blends one run and compares every pixel with the reference.
+ * @return Number of mismatching pixels.
+ */
+static int checkRun(const uint16_t* from, const uint16_t* to, uint16_t* dst, size_t count, uint8_t alpha, bool swapped) {
+  uint16_t expected[1024];
+  referenceBlendRow(expected, from, to, count, alpha, swapped);
+  rgb565BlendRow(dst, from, to, count, alpha, swapped);
+  int bad = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (dst[i] != expected[i]) {
+      if (bad == 0) {
+        printf("  mismatch: from %04X to %04X alpha %u swapped %d: got %04X, expected %04X\n",
+               from[i], to[i], alpha, swapped, dst[i], expected[i]);
+      }
+      bad++;
+    }
+  }
+  return bad;
+}
+
+static int testCorrectness() {
+  static uint16_t from[1026], to[1026], dst[1026], alias[1026];
+  int bad = 0;
+  int runs = 0;
+  srand(1);
+
+  // Extreme fields: all combinations of black, white and single-channel maxima
+  static const uint16_t corners[] = {0x0000, 0xFFFF, 0xF800, 0x07E0, 0x001F, 0x8410, 0x7BEF};
+  const size_t cornerCount = sizeof(corners) / sizeof(corners[0]);
+  for (size_t i = 0; i < cornerCount; i++) {
+    for (size_t j = 0; j < cornerCount; j++) {
+      from[i * cornerCount + j] = corners[i];
+      to[i * cornerCount + j] = corners[j];
+    }
+  }
+  for (uint8_t alpha = 0; alpha <= RGB565_BLEND_MAX; alpha++) {
+    for (int swapped = 0; swapped < 2; swapped++) {
+      bad += checkRun(from, to, dst, cornerCount * cornerCount, alpha, swapped);
+      runs++;
+    }
+  }
+
+  // Random data at every alignment combination, odd and even lengths
+  for (int iter = 0; iter < 4000; iter++) {
+    size_t count = 1 + rand() % 1023;
+    int fromOffset = rand() % 2, toOffset = rand() % 2, dstOffset = rand() % 2;
+    uint8_t alpha = rand() % (RGB565_BLEND_MAX + 1);
+    bool swapped = rand() % 2;
+    for (size_t i = 0; i < count + 2; i++) {
+      from[i] = (uint16_t)rand();
+      to[i] = (uint16_t)rand();
+    }
+    bad += checkRun(from + fromOffset, to + toOffset, dst + dstOffset, count, alpha, swapped);
+    runs++;
+
+    // In place: dst aliases from
+    uint16_t expected[1024];
+    referenceBlendRow(expected, from + fromOffset, to + toOffset, count, alpha, swapped);
+    for (size_t i = 0; i < count; i++) alias[fromOffset + i] = from[fromOffset + i];
+    rgb565BlendRow(alias + fromOffset, alias + fromOffset, to + toOffset, count, alpha, swapped);
+    for (size_t i = 0; i < count; i++) {
+      if (alias[fromOffset + i] != expected[i]) bad++;
+    }
+    runs++;
+  }
+
+  printf("correctness: %d runs, %d mismatching pixels\n", runs, bad);
+  return bad;
+}
+
+static void testTiming() {
+  const size_t pixels = (size_t)FRAME_WIDTH * FRAME_HEIGHT;
+  uint16_t* from = (uint16_t*)malloc(pixels * sizeof(uint16_t));
+  uint16_t* to = (uint16_t*)malloc(pixels * sizeof(uint16_t));
+  uint16_t* dst = (uint16_t*)malloc(pixels * sizeof(uint16_t));
+  for (size_t i = 0; i < pixels; i++) {
+    from[i] = (uint16_t)(i * 2654435761UL >> 16);
+    to[i] = (uint16_t)~from[i];
+  }
+
+  volatile uint16_t sink = 0; // Keeps the output observable
+  uint32_t start = nowUs();
+  for (int n = 0; n < TIMING_ITERATIONS; n++) {
+    referenceBlendRow(dst, from, to, pixels, (uint8_t)(n % (RGB565_BLEND_MAX + 1)), true);
+    sink = sink + dst[n % pixels];
+  }
+  uint32_t scalarUs = (nowUs() - start) / TIMING_ITERATIONS;
+
+  start = nowUs();
+  for (int n = 0; n < TIMING_ITERATIONS; n++) {
+    rgb565BlendRow(dst, from, to, pixels, (uint8_t)(n % (RGB565_BLEND_MAX + 1)), true);
+    sink = sink + dst[n % pixels];
+  }
+  uint32_t swarUs = (nowUs() - start) / TIMING_ITERATIONS;
+
+  printf("timing (%ux%u, swapped, %d frames):\n", FRAME_WIDTH, FRAME_HEIGHT, TIMING_ITERATIONS);
+  printf("  scalar reference     %6u us/frame\n", scalarUs);
+  printf("  rgb565BlendRow       %6u us/frame (%.1fx)\n", swarUs, swarUs > 0 ? (double)scalarUs / swarUs : 0.0);
+  printf("  rgb565BlendBenchmark %6u us/frame (8-row bands)\n", rgb565BlendBenchmark(FRAME_WIDTH, FRAME_HEIGHT, TIMING_ITERATIONS));
+
+  free(from);
+  free(to);
+  free(dst);
+}
+
+int main() {
+  int bad = testCorrectness();
+  testTiming();
+  return bad == 0 ? 0 : 1;
+}